@@ -5,9 +5,31 @@
 #include "sds.h"
 #include "ts_macro.h"
 #include "ts_cleanup.h"
+#include "ts_bigalloc.h"
 #include "ts_vec.h"
+#include "ts_deque.h"
+#include "ts_soa.h"
+#include "ts_segvec.h"
+#include "ts_heap.h"
+#include "ts_btree.h"
+#include "ts_sorted.h"
+#include "ts_slotmap.h"
+#include "ts_intpack.h"
+#include "ts_bitset.h"
+#include "ts_hmap.h"
+#include "ts_chmap.h"
+#include "ts_queue.h"
+#include "ts_vecio.h"
 #include "ts_general.h"
 #include "ts_string.h"
+#include "ts_strview.h"
+#include "ts_tokenize.h"
+#include "ts_search.h"
+#include "ts_intern.h"
+#include "ts_parse.h"
+#include "ts_utf8.h"
+#include "ts_rope.h"
+#include "ts_arena.h"
 #include "ts_mdalloc.h"
 #include "ts_base64.h"
 #include "ts_fileio.h"
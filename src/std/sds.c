@@ -59,6 +59,27 @@ static inline char sdsReqType(size_t string_size) {
     return SDS_TYPE_64;
 }
 
+/* Strings created with an allocator (sdsnewlen_a() and friends) have
+ * SDS_ALLOC_BIT set in the flags byte and the allocation starts with the
+ * sdsallocator pointer, SDS_ALLOC_PREFIX bytes before the header. Such
+ * strings are never of type 5, which keeps the length in the flags bits. */
+#define SDS_ALLOC_PREFIX sizeof(const sdsallocator *)
+
+static inline void *sdsRawMalloc(const sdsallocator *a, size_t size) {
+    return a ? a->malloc(a->ctx,size) : s_malloc_sized(size);
+}
+
+static inline void *sdsRawRealloc(const sdsallocator *a, void *ptr,
+                                  size_t oldsize, size_t size) {
+    return a ? a->realloc(a->ctx,ptr,oldsize,size)
+             : s_realloc_sized(ptr,oldsize,size);
+}
+
+static inline void sdsRawFree(const sdsallocator *a, void *ptr, size_t size) {
+    if (a) a->free(a->ctx,ptr,size);
+    else s_free_sized(ptr,size);
+}
+
 /* Create a new sds string with the content specified by the 'init' pointer
  * and 'initlen'.
  * If NULL is used for 'init' the string is initialized with zero bytes.
@@ -71,21 +92,24 @@ static inline char sdsReqType(size_t string_size) {
  * You can print the string with printf() as there is an implicit \0 at the
  * end of the string. However the string is binary safe and can contain
  * \0 characters in the middle, as the length is stored in the sds header. */
-sds sdsnewlen(const void *init, size_t initlen) {
+static sds sdsnewlenAlloc(const sdsallocator *a, const void *init, size_t initlen) {
     void *sh;
     sds s;
     char type = sdsReqType(initlen);
     /* Empty strings are usually created in order to append. Use type 8
      * since type 5 is not good at this. */
-    if (type == SDS_TYPE_5 && initlen == 0) type = SDS_TYPE_8;
+    if (type == SDS_TYPE_5 && (initlen == 0 || a)) type = SDS_TYPE_8;
     int hdrlen = sdsHdrSize(type);
+    size_t prefix = a ? SDS_ALLOC_PREFIX : 0;
+    unsigned char flagbits = a ? SDS_ALLOC_BIT : 0;
     unsigned char *fp; /* flags pointer. */
 
-    sh = s_malloc(hdrlen+initlen+1);
-    if (!init)
-        memset(sh, 0, hdrlen+initlen+1);
+    sh = sdsRawMalloc(a, prefix+hdrlen+initlen+1);
     if (sh == NULL) return NULL;
-    s = (char*)sh+hdrlen;
+    if (!init)
+        memset(sh, 0, prefix+hdrlen+initlen+1);
+    if (a) memcpy(sh, &a, prefix);
+    s = (char*)sh+prefix+hdrlen;
     fp = ((unsigned char*)s)-1;
     switch(type) {
         case SDS_TYPE_5: {
@@ -96,28 +120,28 @@ sds sdsnewlen(const void *init, size_t initlen) {
             SDS_HDR_VAR(8,s);
             sh->len = initlen;
             sh->alloc = initlen;
-            *fp = type;
+            *fp = type | flagbits;
             break;
         }
         case SDS_TYPE_16: {
             SDS_HDR_VAR(16,s);
             sh->len = initlen;
             sh->alloc = initlen;
-            *fp = type;
+            *fp = type | flagbits;
             break;
         }
         case SDS_TYPE_32: {
             SDS_HDR_VAR(32,s);
             sh->len = initlen;
             sh->alloc = initlen;
-            *fp = type;
+            *fp = type | flagbits;
             break;
         }
         case SDS_TYPE_64: {
             SDS_HDR_VAR(64,s);
             sh->len = initlen;
             sh->alloc = initlen;
-            *fp = type;
+            *fp = type | flagbits;
             break;
         }
     }
@@ -127,6 +151,36 @@ sds sdsnewlen(const void *init, size_t initlen) {
     return s;
 }
 
+sds sdsnewlen(const void *init, size_t initlen) {
+    return sdsnewlenAlloc(NULL, init, initlen);
+}
+
+/* Like sdsnewlen() but the memory comes from the allocator 'a', which must
+ * outlive the string. The string remembers it: sdsMakeRoomFor(), sdsfree()
+ * and every function built on them use the same allocator, so the string
+ * is used exactly like a heap one. */
+sds sdsnewlen_a(const sdsallocator *a, const void *init, size_t initlen) {
+    return sdsnewlenAlloc(a, init, initlen);
+}
+
+sds sdsempty_a(const sdsallocator *a) {
+    return sdsnewlenAlloc(a, "", 0);
+}
+
+sds sdsnew_a(const sdsallocator *a, const char *init) {
+    size_t initlen = (init == NULL) ? 0 : strlen(init);
+    return sdsnewlenAlloc(a, init, initlen);
+}
+
+/* Return the allocator of a string made with sdsnewlen_a() and friends,
+ * NULL for strings using the default allocator. */
+const sdsallocator *sdsgetallocator(const sds s) {
+    const sdsallocator *a;
+    if (!SDS_HAS_ALLOC(s[-1])) return NULL;
+    memcpy(&a, s-sdsHdrSize(s[-1])-SDS_ALLOC_PREFIX, sizeof(a));
+    return a;
+}
+
 /* Create an empty (zero length) sds string. Even in this case the string
  * always has an implicit null term. */
 sds sdsempty(void) {
@@ -147,7 +201,7 @@ sds sdsdup(const sds s) {
 /* Free an sds string. No operation is performed if 's' is NULL. */
 void sdsfree(sds s) {
     if (s == NULL) return;
-    s_free((char*)s-sdsHdrSize(s[-1]));
+    sdsRawFree(sdsgetallocator(s), sdsAllocPtr(s), sdsAllocSize(s));
 }
 
 /* Set the sds string length to the length as obtained with strlen(), so
@@ -187,15 +241,19 @@ void sdsclear(sds s) {
 sds sdsMakeRoomFor(sds s, size_t addlen) {
     void *sh, *newsh;
     size_t avail = sdsavail(s);
-    size_t len, newlen;
+    size_t len, newlen, oldsize, prefix;
     char type, oldtype = s[-1] & SDS_TYPE_MASK;
     int hdrlen;
+    const sdsallocator *a;
 
     /* Return ASAP if there is enough space left. */
     if (avail >= addlen) return s;
 
     len = sdslen(s);
-    sh = (char*)s-sdsHdrSize(oldtype);
+    a = sdsgetallocator(s);
+    prefix = a ? SDS_ALLOC_PREFIX : 0;
+    sh = sdsAllocPtr(s);
+    oldsize = sdsAllocSize(s);
     newlen = (len+addlen);
     if (newlen < SDS_MAX_PREALLOC)
         newlen *= 2;
@@ -211,18 +269,19 @@ sds sdsMakeRoomFor(sds s, size_t addlen) {
 
     hdrlen = sdsHdrSize(type);
     if (oldtype==type) {
-        newsh = s_realloc(sh, hdrlen+newlen+1);
+        newsh = sdsRawRealloc(a, sh, oldsize, prefix+hdrlen+newlen+1);
         if (newsh == NULL) return NULL;
-        s = (char*)newsh+hdrlen;
+        s = (char*)newsh+prefix+hdrlen;
     } else {
         /* Since the header size changes, need to move the string forward,
          * and can't use realloc */
-        newsh = s_malloc(hdrlen+newlen+1);
+        newsh = sdsRawMalloc(a, prefix+hdrlen+newlen+1);
         if (newsh == NULL) return NULL;
-        memcpy((char*)newsh+hdrlen, s, len+1);
-        s_free(sh);
-        s = (char*)newsh+hdrlen;
-        s[-1] = type;
+        memcpy(newsh, sh, prefix);
+        memcpy((char*)newsh+prefix+hdrlen, s, len+1);
+        sdsRawFree(a, sh, oldsize);
+        s = (char*)newsh+prefix+hdrlen;
+        s[-1] = type | (a ? SDS_ALLOC_BIT : 0);
         sdssetlen(s, len);
     }
     sdssetalloc(s, newlen);
@@ -240,21 +299,26 @@ sds sdsRemoveFreeSpace(sds s) {
     char type, oldtype = s[-1] & SDS_TYPE_MASK;
     int hdrlen;
     size_t len = sdslen(s);
-    sh = (char*)s-sdsHdrSize(oldtype);
+    size_t oldsize = sdsAllocSize(s);
+    const sdsallocator *a = sdsgetallocator(s);
+    size_t prefix = a ? SDS_ALLOC_PREFIX : 0;
+    sh = sdsAllocPtr(s);
 
     type = sdsReqType(len);
+    if (type == SDS_TYPE_5 && a) type = SDS_TYPE_8;
     hdrlen = sdsHdrSize(type);
     if (oldtype==type) {
-        newsh = s_realloc(sh, hdrlen+len+1);
+        newsh = sdsRawRealloc(a, sh, oldsize, prefix+hdrlen+len+1);
         if (newsh == NULL) return NULL;
-        s = (char*)newsh+hdrlen;
+        s = (char*)newsh+prefix+hdrlen;
     } else {
-        newsh = s_malloc(hdrlen+len+1);
+        newsh = sdsRawMalloc(a, prefix+hdrlen+len+1);
         if (newsh == NULL) return NULL;
-        memcpy((char*)newsh+hdrlen, s, len+1);
-        s_free(sh);
-        s = (char*)newsh+hdrlen;
-        s[-1] = type;
+        memcpy(newsh, sh, prefix);
+        memcpy((char*)newsh+prefix+hdrlen, s, len+1);
+        sdsRawFree(a, sh, oldsize);
+        s = (char*)newsh+prefix+hdrlen;
+        s[-1] = type | (a ? SDS_ALLOC_BIT : 0);
         sdssetlen(s, len);
     }
     sdssetalloc(s, len);
@@ -267,16 +331,19 @@ sds sdsRemoveFreeSpace(sds s) {
  * 2) The string.
  * 3) The free buffer at the end if any.
  * 4) The implicit null term.
+ * 5) The allocator pointer, for strings made with sdsnewlen_a().
  */
 size_t sdsAllocSize(sds s) {
     size_t alloc = sdsalloc(s);
-    return sdsHdrSize(s[-1])+alloc+1;
+    size_t prefix = SDS_HAS_ALLOC(s[-1]) ? SDS_ALLOC_PREFIX : 0;
+    return prefix+sdsHdrSize(s[-1])+alloc+1;
 }
 
 /* Return the pointer of the actual SDS allocation (normally SDS strings
  * are referenced by the start of the string buffer). */
 void *sdsAllocPtr(sds s) {
-    return (void*) (s-sdsHdrSize(s[-1]));
+    size_t prefix = SDS_HAS_ALLOC(s[-1]) ? SDS_ALLOC_PREFIX : 0;
+    return (void*) (s-sdsHdrSize(s[-1])-prefix);
 }
 
 /* Increment the sds length and decrements the left free space at the
@@ -412,6 +479,42 @@ sds sdscpy(sds s, const char *t) {
     return sdscpylen(s, t, strlen(t));
 }
 
+/* "00" "01" ... "99": integers are written two digits per step, from the
+ * last digit backwards, after counting the digits up front. */
+static const char sdsDigitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static inline int sdsDigitCount(unsigned long long v) {
+    int n = 1;
+    for (;;) {
+        if (v < 10) return n;
+        if (v < 100) return n+1;
+        if (v < 1000) return n+2;
+        if (v < 10000) return n+3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+static inline void sdsWriteDigits(char *end, unsigned long long v) {
+    while (v >= 100) {
+        unsigned i = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--end = sdsDigitPairs[i+1];
+        *--end = sdsDigitPairs[i];
+    }
+    if (v >= 10) {
+        *--end = sdsDigitPairs[v*2+1];
+        *--end = sdsDigitPairs[v*2];
+    } else {
+        *--end = '0'+(char)v;
+    }
+}
+
 /* Helper for sdscatlonglong() doing the actual number -> string
  * conversion. 's' must point to a string with room for at least
  * SDS_LLSTR_SIZE bytes.
@@ -420,62 +523,27 @@ sds sdscpy(sds s, const char *t) {
  * representation stored at 's'. */
 #define SDS_LLSTR_SIZE 21
 int sdsll2str(char *s, long long value) {
-    char *p, aux;
     unsigned long long v;
-    size_t l;
-
-    /* Generate the string representation, this method produces
-     * an reversed string. */
-    v = (value < 0) ? -value : value;
-    p = s;
-    do {
-        *p++ = '0'+(v%10);
-        v /= 10;
-    } while(v);
-    if (value < 0) *p++ = '-';
-
-    /* Compute length and add null term. */
-    l = p-s;
-    *p = '\0';
-
-    /* Reverse the string. */
-    p--;
-    while(s < p) {
-        aux = *s;
-        *s = *p;
-        *p = aux;
-        s++;
-        p--;
+    int l = 0;
+
+    if (value < 0) {
+        v = 0ULL - (unsigned long long)value;
+        s[l++] = '-';
+    } else {
+        v = value;
     }
+    l += sdsDigitCount(v);
+    sdsWriteDigits(s+l,v);
+    s[l] = '\0';
     return l;
 }
 
 /* Identical sdsll2str(), but for unsigned long long type. */
 int sdsull2str(char *s, unsigned long long v) {
-    char *p, aux;
-    size_t l;
-
-    /* Generate the string representation, this method produces
-     * an reversed string. */
-    p = s;
-    do {
-        *p++ = '0'+(v%10);
-        v /= 10;
-    } while(v);
-
-    /* Compute length and add null term. */
-    l = p-s;
-    *p = '\0';
-
-    /* Reverse the string. */
-    p--;
-    while(s < p) {
-        aux = *s;
-        *s = *p;
-        *p = aux;
-        s++;
-        p--;
-    }
+    int l = sdsDigitCount(v);
+
+    sdsWriteDigits(s+l,v);
+    s[l] = '\0';
     return l;
 }
 
@@ -490,6 +558,244 @@ sds sdsfromlonglong(long long value) {
     return sdsnewlen(buf,len);
 }
 
+/* Append the decimal representation of 'value' to 's'.
+ * Same as sdscatfmt(s,"%I",value) but without parsing a format string. */
+sds sdscati64(sds s, int64_t value) {
+    s = sdsMakeRoomFor(s,SDS_LLSTR_SIZE);
+    if (s == NULL) return NULL;
+    sdsinclen(s,sdsll2str(s+sdslen(s),value));
+    return s;
+}
+
+/* Double to shortest decimal string, Grisu2 (Florian Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers", 2010).
+ *
+ * The digits generated always read back to the same double with strtod().
+ * They are the shortest such string for all but a tiny fraction of inputs,
+ * where one more digit than needed is produced. Only 87 cached powers of ten
+ * are needed, instead of printf's arbitrary precision arithmetic. */
+typedef struct { uint64_t f; int e; } sdsDiyFp;
+
+static const uint64_t sdsCachedPowersF[87] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const int16_t sdsCachedPowersE[87] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+static const uint64_t sdsPow10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* 64x64 -> upper 64 bits of the product, rounded. */
+static inline sdsDiyFp sdsDiyFpMul(sdsDiyFp a, sdsDiyFp b) {
+    sdsDiyFp r;
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128)a.f * b.f;
+    r.f = (uint64_t)(p >> 64) + (((uint64_t)p >> 63) & 1);
+#else
+    const uint64_t M32 = 0xFFFFFFFFu;
+    uint64_t a1 = a.f >> 32, a0 = a.f & M32, b1 = b.f >> 32, b0 = b.f & M32;
+    uint64_t ac = a1*b1, bc = a0*b1, ad = a1*b0, bd = a0*b0;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32) + (1U << 31);
+    r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+#endif
+    r.e = a.e + b.e + 64;
+    return r;
+}
+
+static inline sdsDiyFp sdsDiyFpNormalize(sdsDiyFp a) {
+    int s = __builtin_clzll(a.f);
+    a.f <<= s;
+    a.e -= s;
+    return a;
+}
+
+static inline void sdsGrisuRound(char *buf, int len, uint64_t delta, uint64_t rest,
+                                 uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len-1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* Generates the digits of 'value' (finite, > 0) into buf, returns their count.
+ * The value is buf * 10^K. */
+static int sdsGrisu2(double value, char *buf, int *K) {
+    uint64_t u, delta, p2, tmp;
+    uint32_t p1;
+    sdsDiyFp v, w, wp, wm, c, one;
+    int be, kappa, len = 0, k, idx, shift;
+    double dk;
+
+    memcpy(&u,&value,sizeof(u));
+    be = (int)((u >> 52) & 0x7FF);
+    v.f = u & 0xFFFFFFFFFFFFFULL;
+    if (be) {
+        v.f += 1ULL << 52;
+        v.e = be - 1075;
+    } else {
+        v.e = 1 - 1075;
+    }
+
+    /* boundaries m- and m+, normalized to the exponent of m+ */
+    wp.f = (v.f << 1) + 1;
+    wp.e = v.e - 1;
+    while (!(wp.f & (1ULL << 53))) { wp.f <<= 1; wp.e--; }
+    wp.f <<= 10;
+    wp.e -= 10;
+    if (v.f == (1ULL << 52)) {
+        wm.f = (v.f << 2) - 1;
+        wm.e = v.e - 2;
+    } else {
+        wm.f = (v.f << 1) - 1;
+        wm.e = v.e - 1;
+    }
+    wm.f <<= wm.e - wp.e;
+    wm.e = wp.e;
+
+    /* cached power c = 10^-K bringing m+ into [2^-60, 2^-32) scaled by 2^64 */
+    dk = (-61 - wp.e) * 0.30102999566398114 + 347;
+    k = (int)dk;
+    if (dk - k > 0.0) k++;
+    idx = (k >> 3) + 1;
+    *K = -(-348 + idx * 8);
+    c.f = sdsCachedPowersF[idx];
+    c.e = sdsCachedPowersE[idx];
+
+    w = sdsDiyFpMul(sdsDiyFpNormalize(v),c);
+    wp = sdsDiyFpMul(wp,c);
+    wm = sdsDiyFpMul(wm,c);
+    wm.f++;
+    wp.f--;
+    delta = wp.f - wm.f;
+
+    /* digit generation */
+    shift = -wp.e;
+    one.f = 1ULL << shift;
+    p1 = (uint32_t)(wp.f >> shift);
+    p2 = wp.f & (one.f - 1);
+    kappa = sdsDigitCount(p1);
+    while (kappa > 0) {
+        uint32_t d = p1 / (uint32_t)sdsPow10[kappa-1];
+        p1 %= (uint32_t)sdsPow10[kappa-1];
+        if (d || len) buf[len++] = '0'+(char)d;
+        kappa--;
+        tmp = ((uint64_t)p1 << shift) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            sdsGrisuRound(buf,len,delta,tmp,sdsPow10[kappa] << shift,wp.f - w.f);
+            return len;
+        }
+    }
+    for (;;) {
+        char d;
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> shift);
+        if (d || len) buf[len++] = '0'+d;
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            idx = -kappa;
+            sdsGrisuRound(buf,len,delta,p2,one.f,(wp.f - w.f) * (idx < 20 ? sdsPow10[idx] : 0));
+            return len;
+        }
+    }
+}
+
+/* Append the shortest decimal string that reads back as 'value'.
+ * Plain notation for 1e-6 <= |value| < 1e21, scientific otherwise, the
+ * same choice JavaScript's Number.toString() makes: 0.5, 100, 1e+21, 1.5e-7. Integral values have no trailing ".0". Non finite values are
+ * written as nan, inf and -inf. */
+sds sdscatdouble(sds s, double value) {
+    char buf[32], digits[20], *p = buf;
+    int len, K, kk, i;
+    uint64_t u;
+
+    memcpy(&u,&value,sizeof(u));
+    if (((u >> 52) & 0x7FF) == 0x7FF)
+        return sdscat(s, (u & 0xFFFFFFFFFFFFFULL) ? "nan" : (u >> 63) ? "-inf" : "inf");
+    if (u >> 63) {
+        *p++ = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        *p++ = '0';
+        return sdscatlen(s,buf,p-buf);
+    }
+
+    len = sdsGrisu2(value,digits,&K);
+    kk = len + K;   /* 10^(kk-1) <= value < 10^kk */
+    if (K >= 0 && kk <= 21) {
+        /* 1234e3 -> 1234000 */
+        memcpy(p,digits,len); p += len;
+        for (i = 0; i < K; i++) *p++ = '0';
+    } else if (kk > 0 && kk <= 21) {
+        /* 1234e-2 -> 12.34 */
+        memcpy(p,digits,kk); p += kk;
+        *p++ = '.';
+        memcpy(p,digits+kk,len-kk); p += len-kk;
+    } else if (kk > -6 && kk <= 0) {
+        /* 1234e-6 -> 0.001234 */
+        *p++ = '0';
+        *p++ = '.';
+        for (i = 0; i < -kk; i++) *p++ = '0';
+        memcpy(p,digits,len); p += len;
+    } else {
+        /* 1234e30 -> 1.234e+33 */
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p,digits+1,len-1); p += len-1;
+        }
+        *p++ = 'e';
+        *p++ = kk - 1 < 0 ? '-' : '+';
+        p += sdsull2str(p, kk - 1 < 0 ? 1 - kk : kk - 1);
+    }
+    return sdscatlen(s,buf,p-buf);
+}
+
 /* Like sdscatprintf() but gets va_list instead of being variadic. */
 sds sdscatvprintf(sds s, const char *fmt, va_list ap) {
     va_list cpy;
@@ -567,6 +873,7 @@ sds sdscatprintf(sds s, const char *fmt, ...) {
  * %I - 64 bit signed integer (long long, int64_t)
  * %u - unsigned int
  * %U - 64 bit unsigned integer (unsigned long long, uint64_t)
+ * %g - double, shortest round trip form (see sdscatdouble, not printf's %g)
  * %% - Verbatim "%" character.
  */
 sds sdscatfmt(sds s, char const *fmt, ...) {
@@ -639,6 +946,10 @@ sds sdscatfmt(sds s, char const *fmt, ...) {
                     i += l;
                 }
                 break;
+            case 'g':
+                s = sdscatdouble(s,va_arg(ap,double));
+                i = sdslen(s);
+                break;
             default: /* Handle %% and generally %<unknown>. */
                 s[i++] = next;
                 sdsinclen(s,1);
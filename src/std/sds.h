@@ -78,6 +78,20 @@ struct __attribute__ ((__packed__)) sdshdr64 {
 #define SDS_HDR_VAR(T,s) struct sdshdr##T *sh = (void*)((s)-(sizeof(struct sdshdr##T)));
 #define SDS_HDR(T,s) ((struct sdshdr##T *)((s)-(sizeof(struct sdshdr##T))))
 #define SDS_TYPE_5_LEN(f) ((f)>>SDS_TYPE_BITS)
+/* Flags bit set on strings with their own allocator. Type 5 keeps its
+ * length in these bits, so it never has one. */
+#define SDS_ALLOC_BIT 8
+#define SDS_HAS_ALLOC(f) (((f)&SDS_TYPE_MASK) != SDS_TYPE_5 && ((f)&SDS_ALLOC_BIT))
+
+/* Allocator context for sdsnewlen_a() and friends. Sizes are passed back
+ * to realloc / free, so arena or pool allocators don't need to track them.
+ * 'ctx' is handed to every call. */
+typedef struct sdsallocator {
+    void *(*malloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t oldsize, size_t size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} sdsallocator;
 
 static inline size_t sdslen(const sds s) {
     unsigned char flags = s[-1];
@@ -213,6 +227,10 @@ static inline void sdssetalloc(sds s, size_t newlen) {
 sds sdsnewlen(const void *init, size_t initlen);
 sds sdsnew(const char *init);
 sds sdsempty(void);
+sds sdsnewlen_a(const sdsallocator *a, const void *init, size_t initlen);
+sds sdsnew_a(const sdsallocator *a, const char *init);
+sds sdsempty_a(const sdsallocator *a);
+const sdsallocator *sdsgetallocator(const sds s);
 sds sdsdup(const sds s);
 void sdsfree(sds s);
 sds sdsgrowzero(sds s, size_t len);
@@ -241,6 +259,8 @@ void sdsfreesplitres(sds *tokens, int count);
 void sdstolower(sds s);
 void sdstoupper(sds s);
 sds sdsfromlonglong(long long value);
+sds sdscati64(sds s, int64_t value);
+sds sdscatdouble(sds s, double value);
 sds sdscatrepr(sds s, const char *p, size_t len);
 sds *sdssplitargs(const char *line, int *argc);
 sds sdsmapchars(sds s, const char *from, const char *to, size_t setlen);
@@ -277,4 +297,17 @@ static inline void auto_cleanup_sds(sds *s) {
 #define s_free    free
 #endif
 
+/* The string buffers themselves go through the sized variants below, they are
+ * told the current allocation size (sdsAllocSize) so that with USE_TS_BIGALLOC
+ * large strings can live in mmap regions grown with mremap (see ts_bigalloc.h). */
+#if defined(USE_TS_BIGALLOC) && !defined(CUSTOM_SDS_ALLOC)
+#define s_malloc_sized(sz)              ts_big_malloc(sz)
+#define s_realloc_sized(p, oldsz, sz)   ts_big_realloc(p, oldsz, sz)
+#define s_free_sized(p, sz)             ts_big_free(p, sz)
+#else
+#define s_malloc_sized(sz)              s_malloc(sz)
+#define s_realloc_sized(p, oldsz, sz)   ((void)(oldsz), s_realloc(p, sz))
+#define s_free_sized(p, sz)             ((void)(sz), s_free(p))
+#endif
+
 #endif
@@ -0,0 +1,145 @@
+#include "libts.h"
+
+#define TS_ARENA_ALIGN(n) (((n) + 15) & ~(size_t) 15)
+// larger requests would wrap in TS_ARENA_ALIGN or in the chunk header addition
+#define TS_ARENA_MAX      (SIZE_MAX - sizeof(ts_arena_chunk_t) - 15)
+
+static void * ts_arena_sds_malloc(void *ctx, size_t size) {
+  return ts_arena_malloc((ts_arena_t *) ctx, size);
+}
+
+static void * ts_arena_sds_realloc(void *ctx, void *ptr, size_t oldsize, size_t size) {
+  return ts_arena_realloc((ts_arena_t *) ctx, ptr, oldsize, size);
+}
+
+static void ts_arena_sds_free(void *ctx, void *ptr, size_t size) {
+  ts_arena_free((ts_arena_t *) ctx, ptr, size);
+}
+
+void ts_arena_init(ts_arena_t *a, size_t chunk) {
+  memset(a, 0, sizeof(*a));
+  a->chunk         = TS_ARENA_ALIGN(chunk ? chunk : TS_ARENA_CHUNK);
+  a->alloc.malloc  = ts_arena_sds_malloc;
+  a->alloc.realloc = ts_arena_sds_realloc;
+  a->alloc.free    = ts_arena_sds_free;
+  a->alloc.ctx     = a;
+}
+
+void ts_arena_destroy(ts_arena_t *a) {
+  ts_arena_chunk_t *c, *next;
+  for(c = a->chunks ; c ; c = next) {
+    next = c->next;
+    free(c);
+  }
+  a->chunks = NULL;
+  a->cur = a->end = a->last = NULL;
+}
+
+// keeps one bump chunk for the next round
+void ts_arena_reset(ts_arena_t *a) {
+  ts_arena_chunk_t *c, *next, *keep = NULL;
+  for(c = a->chunks ; c ; c = next) {
+    next = c->next;
+    if(keep == NULL && c->size == a->chunk) keep = c;
+    else free(c);
+  }
+  a->chunks = keep;
+  a->last   = NULL;
+  a->cur    = keep ? keep->data : NULL;
+  a->end    = keep ? keep->data + keep->size : NULL;
+  if(keep) keep->prev = keep->next = NULL;
+}
+
+static inline int ts_arena_large(const ts_arena_t *a, size_t size) {
+  return TS_ARENA_ALIGN(size) > a->chunk / 4;
+}
+
+static inline ts_arena_chunk_t * ts_arena_chunk_of(void *ptr) {
+  return (ts_arena_chunk_t *)((char *) ptr - offsetof(ts_arena_chunk_t, data));
+}
+
+static ts_arena_chunk_t * ts_arena_new_chunk(size_t size) {
+  ts_arena_chunk_t *c = (ts_arena_chunk_t *) malloc(sizeof(*c) + size);
+  tsunlikely_if(c == NULL) return NULL;
+  c->prev = c->next = NULL;
+  c->size = size;
+  return c;
+}
+
+static void ts_arena_unlink(ts_arena_t *a, ts_arena_chunk_t *c) {
+  if(c->prev) c->prev->next = c->next;
+  else a->chunks = c->next;
+  if(c->next) c->next->prev = c->prev;
+}
+
+// large chunks go after the bump chunk, so it stays at the head
+static void ts_arena_link_large(ts_arena_t *a, ts_arena_chunk_t *c) {
+  ts_arena_chunk_t *at = a->chunks && a->chunks->size == a->chunk ? a->chunks : NULL;
+  c->prev = at;
+  c->next = at ? at->next : a->chunks;
+  if(c->next) c->next->prev = c;
+  if(at) at->next = c;
+  else a->chunks = c;
+}
+
+void * ts_arena_malloc(ts_arena_t *a, size_t size) {
+  ts_arena_chunk_t *c;
+  size_t            n;
+
+  tsunlikely_if(size > TS_ARENA_MAX) return NULL;
+  n = size ? TS_ARENA_ALIGN(size) : 16;
+  if(ts_arena_large(a, size)) {
+    tsunlikely_if( (c = ts_arena_new_chunk(n)) == NULL ) return NULL;
+    ts_arena_link_large(a, c);
+    return c->data;
+  }
+  if((size_t)(a->end - a->cur) < n) {
+    tsunlikely_if( (c = ts_arena_new_chunk(a->chunk)) == NULL ) return NULL;
+    c->next = a->chunks;
+    if(c->next) c->next->prev = c;
+    a->chunks = c;
+    a->cur    = c->data;
+    a->end    = c->data + c->size;
+  }
+  a->last = a->cur;
+  a->cur += n;
+  return a->last;
+}
+
+void ts_arena_free(ts_arena_t *a, void *ptr, size_t size) {
+  if(ptr == NULL) return;
+  if(ts_arena_large(a, size)) {
+    ts_arena_chunk_t *c = ts_arena_chunk_of(ptr);
+    ts_arena_unlink(a, c);
+    free(c);
+  } else if(ptr == a->last) {
+    a->cur  = a->last;
+    a->last = NULL;
+  }
+}
+
+void * ts_arena_realloc(ts_arena_t *a, void *ptr, size_t oldsize, size_t size) {
+  void *p;
+
+  tsunlikely_if(size > TS_ARENA_MAX) return NULL;
+  if(ptr == NULL) return ts_arena_malloc(a, size);
+  if(ts_arena_large(a, oldsize) && ts_arena_large(a, size)) {
+    ts_arena_chunk_t *c = ts_arena_chunk_of(ptr), *prev = c->prev, *next = c->next;
+    size_t            n = TS_ARENA_ALIGN(size);
+    tsunlikely_if( (c = (ts_arena_chunk_t *) realloc(c, sizeof(*c) + n)) == NULL ) return NULL;
+    c->size = n;
+    if(prev) prev->next = c;
+    else a->chunks = c;
+    if(next) next->prev = c;
+    return c->data;
+  }
+  if(ptr == a->last && !ts_arena_large(a, size) &&
+     TS_ARENA_ALIGN(size ? size : 1) <= (size_t)(a->end - a->last)) {
+    a->cur = a->last + TS_ARENA_ALIGN(size ? size : 1);
+    return ptr;
+  }
+  tsunlikely_if( (p = ts_arena_malloc(a, size)) == NULL ) return NULL;
+  memcpy(p, ptr, oldsize < size ? oldsize : size);
+  ts_arena_free(a, ptr, oldsize);
+  return p;
+}
@@ -0,0 +1,52 @@
+#ifndef TS_ARENA_H__
+#define TS_ARENA_H__
+
+#include <stddef.h>
+
+/// ts_arena_t is a bump allocator: allocations are carved out of TS_ARENA_CHUNK byte chunks
+/// and nothing is given back until ts_arena_reset, which releases everything at once. it
+/// suits request scoped data, in particular sds strings:
+///
+///   ts_arena_t ar;
+///   ts_arena_init(&ar, 0);
+///   sds s = sdsnew_a(ts_arena_sdsalloc(&ar), "GET ");   // the string remembers the arena
+///   s = sdscatsds(s, path);                             // grows inside the arena
+///   ...
+///   ts_arena_reset(&ar);                                // every string gone, no sdsfree
+///
+/// allocations are 16 byte aligned. the newest one grows or shrinks in place, and freeing it
+/// gives its bytes back, so an sds that is appended to in a loop doesn't leave a trail of
+/// copies behind. allocations larger than a quarter chunk get a chunk of their own, which
+/// free / realloc release / resize right away.
+
+// realloc / free take the size the block was allocated with (sdsallocator passes it), that
+// is how a block is told apart from the large ones without any per allocation header.
+// the arena must not be moved after init: strings point to its embedded sdsallocator.
+
+#define TS_ARENA_CHUNK 65536
+
+typedef struct ts_arena_chunk {
+  struct ts_arena_chunk *prev, *next;
+  size_t                 size;
+  char                   data[] __attribute__((aligned(16)));
+} ts_arena_chunk_t;
+
+typedef struct {
+  ts_arena_chunk_t *chunks;       // newest bump chunk first, large chunks after it
+  char             *cur, *end;    // free space in the bump chunk
+  char             *last;         // newest allocation in the bump chunk
+  size_t            chunk;
+  sdsallocator      alloc;
+} ts_arena_t;
+
+TSC_EXTERN void   ts_arena_init(ts_arena_t *a, size_t chunk);
+TSC_EXTERN void   ts_arena_destroy(ts_arena_t *a);
+TSC_EXTERN void   ts_arena_reset(ts_arena_t *a);
+TSC_EXTERN void * ts_arena_malloc(ts_arena_t *a, size_t size);
+TSC_EXTERN void * ts_arena_realloc(ts_arena_t *a, void *ptr, size_t oldsize, size_t size);
+TSC_EXTERN void   ts_arena_free(ts_arena_t *a, void *ptr, size_t size);
+
+// allocator for sdsnewlen_a() and friends
+static inline const sdsallocator * ts_arena_sdsalloc(const ts_arena_t *a) { return &a->alloc; }
+
+#endif
@@ -0,0 +1,52 @@
+#include "libts.h"
+
+#ifdef USE_TS_BIGALLOC
+
+static inline size_t ts_big_pages(size_t sz) {
+  static size_t pagesz = 0;
+  if(pagesz == 0) pagesz = (size_t) sysconf(_SC_PAGESIZE);
+  return (sz + pagesz - 1) & ~(pagesz - 1);
+}
+
+static void * ts_big_map(size_t sz) {
+  void *p = mmap(NULL, ts_big_pages(sz), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+void * ts_big_malloc(size_t sz) {
+  if(sz < TS_BIG_THRESHOLD) return malloc(sz);
+  return ts_big_map(sz);
+}
+
+void ts_big_free(void *ptr, size_t sz) {
+  tsunlikely_if(ptr == NULL) return;
+  if(sz < TS_BIG_THRESHOLD) free(ptr);
+  else                      munmap(ptr, ts_big_pages(sz));
+}
+
+// same contract as realloc: on failure NULL is returned and ptr is left untouched
+void * ts_big_realloc(void *ptr, size_t oldsz, size_t newsz) {
+  void *p;
+  
+  if(ptr == NULL) oldsz = 0;
+  
+  if(oldsz < TS_BIG_THRESHOLD && newsz < TS_BIG_THRESHOLD)
+    return realloc(ptr, newsz);
+  
+  if(oldsz >= TS_BIG_THRESHOLD && newsz >= TS_BIG_THRESHOLD) {
+    if(ts_big_pages(oldsz) == ts_big_pages(newsz)) return ptr;
+#ifdef MREMAP_MAYMOVE
+    p = mremap(ptr, ts_big_pages(oldsz), ts_big_pages(newsz), MREMAP_MAYMOVE);
+    return p == MAP_FAILED ? NULL : p;
+#endif
+  }
+  
+  // crossing the threshold (either way), or no mremap available
+  tsunlikely_if( (p = ts_big_malloc(newsz)) == NULL )
+    return NULL;
+  if(ptr) memcpy(p, ptr, oldsz < newsz ? oldsz : newsz);
+  ts_big_free(ptr, oldsz);
+  return p;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TS_BIGALLOC_H__
+#define TS_BIGALLOC_H__
+
+#ifdef USE_TS_BIGALLOC
+
+/// sized allocator for buffers that can grow very large (ts_vec / ts_heap storage and sds).
+/// below TS_BIG_THRESHOLD it is plain malloc / realloc / free.
+/// at or above it memory comes straight from mmap, and growing a mapped buffer is an
+/// mremap(MREMAP_MAYMOVE): the kernel moves page table entries instead of copying the data,
+/// so growing a multi GB vector costs no memcpy and no 2x memory peak.
+
+// the caller passes the current size back in (vec knows m, sds knows its alloc),
+// which is how a mapped block is told apart from a malloc'd one without a header.
+// consequence: a buffer obtained here must only be released with ts_big_free / ts_big_realloc
+// using the exact size it was last allocated with (never free() it directly).
+//
+// with USE_TS_BIGALLOC defined, ts_make_vec, ts_make_heap and sds all route through here.
+// without mremap (non Linux) a mapped block grows by map new / memcpy / unmap old.
+
+#ifndef TS_BIG_THRESHOLD
+  #define TS_BIG_THRESHOLD (1024*1024)
+#endif
+
+TSC_EXTERN void * ts_big_malloc(size_t sz);
+TSC_EXTERN void * ts_big_realloc(void *ptr, size_t oldsz, size_t newsz);
+TSC_EXTERN void   ts_big_free(void *ptr, size_t sz);
+
+#endif
+#endif
@@ -0,0 +1,153 @@
+#include "libts.h"
+
+#define TS_BITSET_RANK_WORDS 8   // one rank entry per 512 bits, i.e. one cache line of words
+
+// zero the bits past n in the last word so popcount / find never see them
+static inline void ts_bitset_trim(ts_bitset_t *b) {
+  if(b->n & 63)
+    b->w[b->nwords - 1] &= ((uint64_t)1 << (b->n & 63)) - 1;
+}
+
+const char * ts_bitset_init(ts_bitset_t *b, size_t nbits) {
+  b->n      = nbits;
+  b->nwords = TS_BITSET_WORDS(nbits);
+  b->rank   = NULL;
+  tsunlikely_if( (b->w = (uint64_t *) calloc(b->nwords ? b->nwords : 1, sizeof(uint64_t))) == NULL )
+    return "OOM";
+  return NULL;
+}
+
+void ts_bitset_destroy(ts_bitset_t *b) {
+  free(b->w);
+  free(b->rank);
+  b->w    = NULL;
+  b->rank = NULL;
+}
+
+void ts_bitset_clearall(ts_bitset_t *b) {
+  memset(b->w, 0, b->nwords * sizeof(uint64_t));
+}
+
+void ts_bitset_setall(ts_bitset_t *b) {
+  memset(b->w, 0xff, b->nwords * sizeof(uint64_t));
+  ts_bitset_trim(b);
+}
+
+size_t ts_bitset_popcount(const ts_bitset_t *b) {
+  size_t cnt = 0;
+  for(size_t i = 0 ; i < b->nwords ; i++)
+    cnt += __builtin_popcountll(b->w[i]);
+  return cnt;
+}
+
+size_t ts_bitset_find_next(const ts_bitset_t *b, size_t i) {
+  size_t   wi = i >> 6;
+  uint64_t w;
+  tsunlikely_if(i >= b->n) return b->n;
+  w = b->w[wi] & (~(uint64_t)0 << (i & 63));
+  while(w == 0) {
+    if(++wi >= b->nwords) return b->n;
+    w = b->w[wi];
+  }
+  return (wi << 6) + __builtin_ctzll(w);
+}
+
+size_t ts_bitset_find_first(const ts_bitset_t *b) {
+  return ts_bitset_find_next(b, 0);
+}
+
+#if defined(__AVX2__)
+#define TS_BITSET_OP(fname, op, vop)                                                    \
+const char * fname(ts_bitset_t *dst, const ts_bitset_t *a, const ts_bitset_t *b) {      \
+  size_t i = 0;                                                                         \
+  tsunlikely_if(dst->n != a->n || a->n != b->n) return "BITSET SIZE MISMATCH";          \
+  for( ; i + 4 <= a->nwords ; i += 4) {                                                 \
+    __m256i x = _mm256_loadu_si256((const __m256i *)(a->w + i));                        \
+    __m256i y = _mm256_loadu_si256((const __m256i *)(b->w + i));                        \
+    _mm256_storeu_si256((__m256i *)(dst->w + i), vop(x, y));                            \
+  }                                                                                     \
+  for( ; i < a->nwords ; i++)                                                           \
+    dst->w[i] = op(a->w[i], b->w[i]);                                                   \
+  return NULL;                                                                          \
+}
+#else
+#define TS_BITSET_OP(fname, op, vop)                                                    \
+const char * fname(ts_bitset_t *dst, const ts_bitset_t *a, const ts_bitset_t *b) {      \
+  tsunlikely_if(dst->n != a->n || a->n != b->n) return "BITSET SIZE MISMATCH";          \
+  for(size_t i = 0 ; i < a->nwords ; i++)                                               \
+    dst->w[i] = op(a->w[i], b->w[i]);                                                   \
+  return NULL;                                                                          \
+}
+#endif
+
+#define TS_BITSET_AND(x, y)     ((x) & (y))
+#define TS_BITSET_OR(x, y)      ((x) | (y))
+#define TS_BITSET_XOR(x, y)     ((x) ^ (y))
+#define TS_BITSET_ANDNOT(x, y)  ((x) & ~(y))
+// note _mm256_andnot_si256(y, x) computes ~y & x
+#define TS_BITSET_VANDNOT(x, y) _mm256_andnot_si256((y), (x))
+
+TS_BITSET_OP(ts_bitset_and,    TS_BITSET_AND,    _mm256_and_si256)
+TS_BITSET_OP(ts_bitset_or,     TS_BITSET_OR,     _mm256_or_si256)
+TS_BITSET_OP(ts_bitset_xor,    TS_BITSET_XOR,    _mm256_xor_si256)
+TS_BITSET_OP(ts_bitset_andnot, TS_BITSET_ANDNOT, TS_BITSET_VANDNOT)
+
+const char * ts_bitset_build_rank(ts_bitset_t *b) {
+  size_t  nblocks = (b->nwords + TS_BITSET_RANK_WORDS - 1) / TS_BITSET_RANK_WORDS;
+  size_t  cnt     = 0;
+  size_t *tmp;
+  
+  tsunlikely_if( (tmp = (size_t *) realloc(b->rank, (nblocks + 1) * sizeof(size_t))) == NULL )
+    return "OOM";
+  b->rank = tmp;
+  
+  for(size_t i = 0 ; i < b->nwords ; i++) {
+    if(i % TS_BITSET_RANK_WORDS == 0)
+      b->rank[i / TS_BITSET_RANK_WORDS] = cnt;
+    cnt += __builtin_popcountll(b->w[i]);
+  }
+  b->rank[nblocks] = cnt;
+  return NULL;
+}
+
+// number of set bits in [0, i)
+size_t ts_bitset_rank(const ts_bitset_t *b, size_t i) {
+  size_t wi, cnt;
+  if(i >= b->n) return b->rank[(b->nwords + TS_BITSET_RANK_WORDS - 1) / TS_BITSET_RANK_WORDS];
+  wi  = i >> 6;
+  cnt = b->rank[wi / TS_BITSET_RANK_WORDS];
+  for(size_t j = wi - wi % TS_BITSET_RANK_WORDS ; j < wi ; j++)
+    cnt += __builtin_popcountll(b->w[j]);
+  return cnt + __builtin_popcountll(b->w[wi] & (((uint64_t)1 << (i & 63)) - 1));
+}
+
+// position of the k-th set bit (k starts at 0), b->n if there are not that many bits set
+size_t ts_bitset_select(const ts_bitset_t *b, size_t k) {
+  size_t   nblocks = (b->nwords + TS_BITSET_RANK_WORDS - 1) / TS_BITSET_RANK_WORDS;
+  size_t   lo = 0, hi = nblocks, mid, wi, c;
+  uint64_t w;
+  
+  tsunlikely_if(k >= b->rank[nblocks]) return b->n;
+  
+  // last block whose rank is <= k
+  while(hi - lo > 1) {
+    mid = (lo + hi) >> 1;
+    if(b->rank[mid] <= k) lo = mid;
+    else                  hi = mid;
+  }
+  
+  k -= b->rank[lo];
+  for(wi = lo * TS_BITSET_RANK_WORDS ; ; wi++) {
+    c = __builtin_popcountll(b->w[wi]);
+    if(k < c) break;
+    k -= c;
+  }
+  
+  w = b->w[wi];
+#if defined(__BMI2__)
+  w = _pdep_u64((uint64_t)1 << k, w);
+#else
+  while(k--) w &= w - 1;
+#endif
+  return (wi << 6) + __builtin_ctzll(w);
+}
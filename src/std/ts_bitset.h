@@ -0,0 +1,50 @@
+#ifndef TS_BITSET_H__
+#define TS_BITSET_H__
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/// ts_bitset packs bits into 64-bit words (vs one int per flag in a vec_int_t, 32x smaller).
+/// whole-set operations (and / or / xor / andnot) are vectorized with AVX2 when compiled with it.
+///
+/// rank / select need a directory built with ts_bitset_build_rank. The directory is a snapshot,
+/// any set / clear / bulk op after that makes it stale (rebuild before ranking again).
+
+typedef struct {
+  size_t    n;        // number of bits
+  size_t    nwords;
+  uint64_t *w;
+  size_t   *rank;     // set bits before each 512 bit block (NULL until ts_bitset_build_rank)
+} ts_bitset_t;
+
+#define TS_BITSET_WORDS(nbits) (((nbits) + 63) >> 6)
+
+static inline void ts_bitset_set(ts_bitset_t *b, size_t i)   { b->w[i >> 6] |=  ((uint64_t)1 << (i & 63)); }
+static inline void ts_bitset_clear(ts_bitset_t *b, size_t i) { b->w[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+static inline void ts_bitset_flip(ts_bitset_t *b, size_t i)  { b->w[i >> 6] ^=  ((uint64_t)1 << (i & 63)); }
+static inline int  ts_bitset_test(const ts_bitset_t *b, size_t i) {
+  return (int)((b->w[i >> 6] >> (i & 63)) & 1);
+}
+static inline size_t ts_bitset_size(const ts_bitset_t *b) { return b->n; }
+
+TSC_EXTERN const char * ts_bitset_init(ts_bitset_t *b, size_t nbits);
+TSC_EXTERN void         ts_bitset_destroy(ts_bitset_t *b);
+TSC_EXTERN void         ts_bitset_clearall(ts_bitset_t *b);
+TSC_EXTERN void         ts_bitset_setall(ts_bitset_t *b);
+TSC_EXTERN size_t       ts_bitset_popcount(const ts_bitset_t *b);
+TSC_EXTERN size_t       ts_bitset_find_first(const ts_bitset_t *b);
+TSC_EXTERN size_t       ts_bitset_find_next(const ts_bitset_t *b, size_t i);
+TSC_EXTERN const char * ts_bitset_and(ts_bitset_t *dst, const ts_bitset_t *a, const ts_bitset_t *b);
+TSC_EXTERN const char * ts_bitset_or(ts_bitset_t *dst, const ts_bitset_t *a, const ts_bitset_t *b);
+TSC_EXTERN const char * ts_bitset_xor(ts_bitset_t *dst, const ts_bitset_t *a, const ts_bitset_t *b);
+TSC_EXTERN const char * ts_bitset_andnot(ts_bitset_t *dst, const ts_bitset_t *a, const ts_bitset_t *b);
+TSC_EXTERN const char * ts_bitset_build_rank(ts_bitset_t *b);
+TSC_EXTERN size_t       ts_bitset_rank(const ts_bitset_t *b, size_t i);
+TSC_EXTERN size_t       ts_bitset_select(const ts_bitset_t *b, size_t k);
+
+#define ts_bitset_foreach(b, iter)                                                      \
+  for ( size_t iter = ts_bitset_find_first(b) ; iter < (b)->n ;                         \
+        iter = ts_bitset_find_next(b, iter + 1) )
+
+#endif
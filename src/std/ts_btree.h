@@ -0,0 +1,350 @@
+#ifndef TS_BTREE_H__
+#define TS_BTREE_H__
+
+/// ts_btree is an ordered map generated per key / value type (same approach as ts_vec).
+/// it is a B+ tree: all key / value pairs live in the leaves, leaves are chained left to right,
+/// so range scans are a walk along the chain and never go back up the tree.
+///
+/// node capacity is derived from TS_BTREE_NODE_BYTES (4 cache lines by default), i.e. the keys
+/// searched in one node are a handful of adjacent cache lines.
+/// less_fn(a, b) must return non-zero when a sorts before b. two keys are equal when neither
+/// is less than the other.
+
+// memory:
+// nodes are carved out of chunks of TS_BTREE_CHUNK nodes owned by the tree, freed nodes go back
+// to a free list. destroy releases the whole tree by freeing the chunks, no node walk.
+// (ts_pool is capped at 2^16 blocks, too small to back a large tree)
+//
+// an insert that fails with OOM leaves the tree as it was: the nodes its splits need are
+// reserved on the free list before anything is modified. TS_BTREE_MALLOC allocates the chunks.
+//
+// iterators (lower_bound / begin / iter_next) stay valid until the next insert / erase.
+
+#ifndef TS_BTREE_NODE_BYTES
+  #define TS_BTREE_NODE_BYTES 256
+#endif
+#ifndef TS_BTREE_MALLOC
+  #define TS_BTREE_MALLOC malloc
+#endif
+#define TS_BTREE_CHUNK 64
+#define TS_BTREE_CAP(sz) \
+  ((TS_BTREE_NODE_BYTES - 16) / (sz) < 4 ? 4 : (TS_BTREE_NODE_BYTES - 16) / (sz))
+
+#define ts_make_btree(name, ktype, vtype, less_fn)                                      \
+  enum {                                                                                \
+    name##_LCAP = TS_BTREE_CAP(sizeof(ktype) + sizeof(vtype)),                          \
+    name##_ICAP = TS_BTREE_CAP(sizeof(ktype) + sizeof(void*)),                          \
+    name##_LMIN = name##_LCAP / 2,                                                      \
+    name##_IMIN = name##_ICAP / 2,                                                      \
+  };                                                                                    \
+  typedef struct name##_leaf {                                                          \
+    unsigned n; struct name##_leaf *next;                                               \
+    ktype keys[name##_LCAP]; vtype vals[name##_LCAP];                                   \
+  } name##_leaf_t;                                                                      \
+  typedef struct {                                                                      \
+    unsigned n; ktype keys[name##_ICAP]; void *child[name##_ICAP + 1];                  \
+  } name##_inner_t;                                                                     \
+  typedef union name##_node {                                                           \
+    name##_leaf_t l; name##_inner_t i; union name##_node *free_next;                    \
+  } name##_node_t;                                                                      \
+  typedef struct name##_chunk {                                                         \
+    struct name##_chunk *next; name##_node_t nodes[TS_BTREE_CHUNK];                     \
+  } name##_chunk_t;                                                                     \
+  typedef struct {                                                                      \
+    void *root; size_t n; unsigned height;                                              \
+    name##_node_t *freelist; name##_chunk_t *chunks;                                    \
+  } name##_t;                                                                           \
+  typedef struct { name##_leaf_t *l; unsigned i; } name##_iter_t;                       \
+  static inline void name##_init(name##_t *t) {                                         \
+    t->root = 0; t->n = 0; t->height = 0; t->freelist = 0; t->chunks = 0; }             \
+  static inline void name##_destroy(name##_t *t) {                                      \
+    name##_chunk_t *c = t->chunks, *next;                                               \
+    while(c) { next = c->next; free(c); c = next; }                                     \
+    name##_init(t); }                                                                   \
+  static inline size_t name##_size(name##_t *t) { return t->n; }                        \
+  static inline int name##__grow(name##_t *t) {                                         \
+    name##_chunk_t *c = (name##_chunk_t*)TS_BTREE_MALLOC(sizeof(name##_chunk_t));       \
+    tsunlikely_if(c == NULL) return 0;                                                  \
+    c->next = t->chunks; t->chunks = c;                                                 \
+    for(size_t j = 0 ; j < TS_BTREE_CHUNK ; ++j) {                                      \
+      c->nodes[j].free_next = t->freelist; t->freelist = &c->nodes[j];                  \
+    }                                                                                   \
+    return 1; }                                                                         \
+  static inline void* name##__alloc(name##_t *t) {                                      \
+    name##_node_t *nd;                                                                  \
+    if(t->freelist == NULL)                                                             \
+      tsunlikely_if(!name##__grow(t)) return NULL;                                      \
+    nd = t->freelist; t->freelist = nd->free_next; return nd; }                         \
+  static inline void name##__free(name##_t *t, void *p) {                               \
+    name##_node_t *nd = (name##_node_t*)p;                                              \
+    nd->free_next = t->freelist; t->freelist = nd; }                                    \
+  /* first index with keys[i] >= k */                                                   \
+  static inline unsigned name##__lower(const ktype *keys, unsigned n, ktype k) {        \
+    unsigned lo = 0, hi = n, mid;                                                       \
+    while(lo < hi) {                                                                    \
+      mid = (lo + hi) >> 1;                                                             \
+      if(less_fn(keys[mid], k)) lo = mid + 1; else hi = mid;                            \
+    }                                                                                   \
+    return lo; }                                                                        \
+  /* first index with keys[i] > k, i.e. the child to descend into */                    \
+  static inline unsigned name##__upper(const ktype *keys, unsigned n, ktype k) {        \
+    unsigned lo = 0, hi = n, mid;                                                       \
+    while(lo < hi) {                                                                    \
+      mid = (lo + hi) >> 1;                                                             \
+      if(less_fn(k, keys[mid])) hi = mid; else lo = mid + 1;                            \
+    }                                                                                   \
+    return lo; }                                                                        \
+  static inline name##_leaf_t* name##__leaf_for(name##_t *t, ktype k) {                 \
+    void *nd = t->root;                                                                 \
+    for(unsigned h = t->height ; h > 0 ; --h) {                                         \
+      name##_inner_t *in = (name##_inner_t*)nd;                                         \
+      nd = in->child[name##__upper(in->keys, in->n, k)];                                \
+    }                                                                                   \
+    return (name##_leaf_t*)nd; }                                                        \
+  static inline vtype* name##_get(name##_t *t, ktype k) {                               \
+    name##_leaf_t *l; unsigned i;                                                       \
+    if(t->root == NULL) return NULL;                                                    \
+    l = name##__leaf_for(t, k);                                                         \
+    i = name##__lower(l->keys, l->n, k);                                                \
+    return (i < l->n && !(less_fn(k, l->keys[i]))) ? &l->vals[i] : NULL; }              \
+  static inline name##_iter_t name##_lower_bound(name##_t *t, ktype k) {                \
+    name##_iter_t it = { NULL, 0 };                                                     \
+    if(t->root == NULL) return it;                                                      \
+    it.l = name##__leaf_for(t, k);                                                      \
+    it.i = name##__lower(it.l->keys, it.l->n, k);                                       \
+    if(it.i == it.l->n) { it.l = it.l->next; it.i = 0; }                                \
+    return it; }                                                                        \
+  static inline name##_iter_t name##_begin(name##_t *t) {                               \
+    name##_iter_t it = { NULL, 0 };                                                     \
+    void *nd = t->root;                                                                 \
+    if(nd == NULL) return it;                                                           \
+    for(unsigned h = t->height ; h > 0 ; --h) nd = ((name##_inner_t*)nd)->child[0];     \
+    it.l = (name##_leaf_t*)nd; return it; }                                             \
+  static inline int name##_iter_valid(name##_iter_t it) { return it.l != NULL; }        \
+  static inline ktype name##_iter_key(name##_iter_t it) { return it.l->keys[it.i]; }    \
+  static inline vtype* name##_iter_val(name##_iter_t it) { return &it.l->vals[it.i]; }  \
+  static inline name##_iter_t name##_iter_next(name##_iter_t it) {                      \
+    if(++it.i == it.l->n) { it.l = it.l->next; it.i = 0; }                              \
+    return it; }                                                                        \
+  /* nodes an insert of k allocates: the leaf and the run of full inner nodes right     \
+     above it split, plus a new root when that run reaches the root */                  \
+  static inline unsigned name##__need(name##_t *t, ktype k) {                           \
+    void *nd = t->root; unsigned full = 0, i; name##_leaf_t *l;                         \
+    for(unsigned h = t->height ; h > 0 ; --h) {                                         \
+      name##_inner_t *in = (name##_inner_t*)nd;                                         \
+      full = in->n == name##_ICAP ? full + 1 : 0;                                       \
+      nd = in->child[name##__upper(in->keys, in->n, k)];                                \
+    }                                                                                   \
+    l = (name##_leaf_t*)nd;                                                             \
+    i = name##__lower(l->keys, l->n, k);                                                \
+    if(l->n < name##_LCAP || (i < l->n && !(less_fn(k, l->keys[i])))) return 0;         \
+    return 1 + full + (full == t->height); }                                            \
+  /* puts cnt nodes on the free list, one chunk covers any insert */                    \
+  static inline int name##__reserve(name##_t *t, unsigned cnt) {                        \
+    name##_node_t *nd = t->freelist; unsigned have = 0;                                 \
+    while(nd != NULL && have < cnt) { nd = nd->free_next; have++; }                     \
+    return have >= cnt || name##__grow(t); }                                            \
+  /* insert into the subtree at nd, on split *split is the new right sibling */         \
+  static inline const char* name##__ins(name##_t *t, void *nd, unsigned h, ktype k,     \
+    vtype v, ktype *skey, void **split) {                                               \
+    const char *estr; unsigned i;                                                       \
+    *split = NULL;                                                                      \
+    if(h == 0) {                                                                        \
+      name##_leaf_t *l = (name##_leaf_t*)nd, *r, *dst;                                  \
+      i = name##__lower(l->keys, l->n, k);                                              \
+      if(i < l->n && !(less_fn(k, l->keys[i]))) { l->vals[i] = v; return NULL; }        \
+      dst = l;                                                                          \
+      if(l->n == name##_LCAP) {                                                         \
+        tsunlikely_if( (r = (name##_leaf_t*)name##__alloc(t)) == NULL ) return "OOM";   \
+        r->n = l->n - l->n / 2; l->n /= 2;                                              \
+        memcpy(r->keys, l->keys + l->n, sizeof(ktype) * r->n);                          \
+        memcpy(r->vals, l->vals + l->n, sizeof(vtype) * r->n);                          \
+        r->next = l->next; l->next = r;                                                 \
+        if(i > l->n) { dst = r; i -= l->n; }                                            \
+        *split = r;                                                                     \
+      }                                                                                 \
+      memmove(dst->keys + i + 1, dst->keys + i, sizeof(ktype) * (dst->n - i));          \
+      memmove(dst->vals + i + 1, dst->vals + i, sizeof(vtype) * (dst->n - i));          \
+      dst->keys[i] = k; dst->vals[i] = v; dst->n++; t->n++;                             \
+      if(*split) *skey = ((name##_leaf_t*)*split)->keys[0];                             \
+      return NULL;                                                                      \
+    } else {                                                                            \
+      name##_inner_t *in = (name##_inner_t*)nd, *r;                                     \
+      ktype ck, keys[name##_ICAP + 1]; void *cs, *child[name##_ICAP + 2];               \
+      unsigned n, mid;                                                                  \
+      i = name##__upper(in->keys, in->n, k);                                            \
+      estr = name##__ins(t, in->child[i], h - 1, k, v, &ck, &cs);                       \
+      tsunlikely_if(estr != NULL) return estr;                                          \
+      if(cs == NULL) return NULL;                                                       \
+      if(in->n < name##_ICAP) {                                                         \
+        memmove(in->keys + i + 1, in->keys + i, sizeof(ktype) * (in->n - i));           \
+        memmove(in->child + i + 2, in->child + i + 1, sizeof(void*) * (in->n - i));     \
+        in->keys[i] = ck; in->child[i + 1] = cs; in->n++;                               \
+        return NULL;                                                                    \
+      }                                                                                 \
+      /* full: lay out all keys / children in a scratch array, then split in two */     \
+      tsunlikely_if( (r = (name##_inner_t*)name##__alloc(t)) == NULL ) return "OOM";    \
+      n = in->n;                                                                        \
+      memcpy(keys, in->keys, sizeof(ktype) * i);                                        \
+      memcpy(child, in->child, sizeof(void*) * (i + 1));                                \
+      keys[i] = ck; child[i + 1] = cs;                                                  \
+      memcpy(keys + i + 1, in->keys + i, sizeof(ktype) * (n - i));                      \
+      memcpy(child + i + 2, in->child + i + 1, sizeof(void*) * (n - i));                \
+      n++; mid = n / 2;                                                                 \
+      in->n = mid;                                                                      \
+      memcpy(in->keys, keys, sizeof(ktype) * mid);                                      \
+      memcpy(in->child, child, sizeof(void*) * (mid + 1));                              \
+      r->n = n - mid - 1;                                                               \
+      memcpy(r->keys, keys + mid + 1, sizeof(ktype) * r->n);                            \
+      memcpy(r->child, child + mid + 1, sizeof(void*) * (r->n + 1));                    \
+      *skey = keys[mid]; *split = r;                                                    \
+      return NULL;                                                                      \
+    } }                                                                                 \
+  static inline const char* name##_insert(name##_t *t, ktype k, vtype v) {              \
+    const char *estr; ktype sk; void *split;                                            \
+    if(t->root == NULL) {                                                               \
+      name##_leaf_t *l = (name##_leaf_t*)name##__alloc(t);                              \
+      tsunlikely_if(l == NULL) return "OOM";                                            \
+      l->n = 0; l->next = NULL; t->root = l; t->height = 0;                             \
+    }                                                                                   \
+    /* every node a split needs is taken before the tree is touched */                  \
+    tsunlikely_if(!name##__reserve(t, name##__need(t, k))) return "OOM";                \
+    estr = name##__ins(t, t->root, t->height, k, v, &sk, &split);                       \
+    tsunlikely_if(estr != NULL) return estr;                                            \
+    if(split) {                                                                         \
+      name##_inner_t *in = (name##_inner_t*)name##__alloc(t);                           \
+      tsunlikely_if(in == NULL) return "OOM";                                           \
+      in->n = 1; in->keys[0] = sk; in->child[0] = t->root; in->child[1] = split;        \
+      t->root = in; t->height++;                                                        \
+    }                                                                                   \
+    return NULL; }                                                                      \
+  /* child i of in is under full, borrow from a sibling or merge with one */            \
+  static inline void name##__fix(name##_t *t, name##_inner_t *in, unsigned i,           \
+    unsigned h) {                                                                       \
+    if(h == 0) {                                                                        \
+      name##_leaf_t *c = (name##_leaf_t*)in->child[i], *s;                              \
+      if(c->n >= name##_LMIN) return;                                                   \
+      if(i > 0 && (s = (name##_leaf_t*)in->child[i - 1])->n > name##_LMIN) {            \
+        memmove(c->keys + 1, c->keys, sizeof(ktype) * c->n);                            \
+        memmove(c->vals + 1, c->vals, sizeof(vtype) * c->n);                            \
+        s->n--; c->keys[0] = s->keys[s->n]; c->vals[0] = s->vals[s->n]; c->n++;         \
+        in->keys[i - 1] = c->keys[0];                                                   \
+        return;                                                                         \
+      }                                                                                 \
+      if(i < in->n && (s = (name##_leaf_t*)in->child[i + 1])->n > name##_LMIN) {        \
+        c->keys[c->n] = s->keys[0]; c->vals[c->n] = s->vals[0]; c->n++; s->n--;         \
+        memmove(s->keys, s->keys + 1, sizeof(ktype) * s->n);                            \
+        memmove(s->vals, s->vals + 1, sizeof(vtype) * s->n);                            \
+        in->keys[i] = s->keys[0];                                                       \
+        return;                                                                         \
+      }                                                                                 \
+    } else {                                                                            \
+      name##_inner_t *c = (name##_inner_t*)in->child[i], *s;                            \
+      if(c->n >= name##_IMIN) return;                                                   \
+      if(i > 0 && (s = (name##_inner_t*)in->child[i - 1])->n > name##_IMIN) {           \
+        memmove(c->keys + 1, c->keys, sizeof(ktype) * c->n);                            \
+        memmove(c->child + 1, c->child, sizeof(void*) * (c->n + 1));                    \
+        c->keys[0] = in->keys[i - 1]; c->child[0] = s->child[s->n]; c->n++;             \
+        in->keys[i - 1] = s->keys[s->n - 1]; s->n--;                                    \
+        return;                                                                         \
+      }                                                                                 \
+      if(i < in->n && (s = (name##_inner_t*)in->child[i + 1])->n > name##_IMIN) {       \
+        c->keys[c->n] = in->keys[i]; c->child[c->n + 1] = s->child[0]; c->n++;          \
+        in->keys[i] = s->keys[0]; s->n--;                                               \
+        memmove(s->keys, s->keys + 1, sizeof(ktype) * s->n);                            \
+        memmove(s->child, s->child + 1, sizeof(void*) * (s->n + 1));                    \
+        return;                                                                         \
+      }                                                                                 \
+    }                                                                                   \
+    /* nobody to borrow from, merge child j + 1 into child j */                         \
+    unsigned j = i > 0 ? i - 1 : i;                                                     \
+    if(h == 0) {                                                                        \
+      name##_leaf_t *a = (name##_leaf_t*)in->child[j];                                  \
+      name##_leaf_t *b = (name##_leaf_t*)in->child[j + 1];                              \
+      memcpy(a->keys + a->n, b->keys, sizeof(ktype) * b->n);                            \
+      memcpy(a->vals + a->n, b->vals, sizeof(vtype) * b->n);                            \
+      a->n += b->n; a->next = b->next;                                                  \
+      name##__free(t, b);                                                               \
+    } else {                                                                            \
+      name##_inner_t *a = (name##_inner_t*)in->child[j];                                \
+      name##_inner_t *b = (name##_inner_t*)in->child[j + 1];                            \
+      a->keys[a->n] = in->keys[j];                                                      \
+      memcpy(a->keys + a->n + 1, b->keys, sizeof(ktype) * b->n);                        \
+      memcpy(a->child + a->n + 1, b->child, sizeof(void*) * (b->n + 1));                \
+      a->n += b->n + 1;                                                                 \
+      name##__free(t, b);                                                               \
+    }                                                                                   \
+    memmove(in->keys + j, in->keys + j + 1, sizeof(ktype) * (in->n - j - 1));           \
+    memmove(in->child + j + 1, in->child + j + 2, sizeof(void*) * (in->n - j - 1));     \
+    in->n--; }                                                                          \
+  static inline int name##__del(name##_t *t, void *nd, unsigned h, ktype k) {           \
+    unsigned i;                                                                         \
+    if(h == 0) {                                                                        \
+      name##_leaf_t *l = (name##_leaf_t*)nd;                                            \
+      i = name##__lower(l->keys, l->n, k);                                              \
+      if(i == l->n || less_fn(k, l->keys[i])) return 0;                                 \
+      memmove(l->keys + i, l->keys + i + 1, sizeof(ktype) * (l->n - i - 1));            \
+      memmove(l->vals + i, l->vals + i + 1, sizeof(vtype) * (l->n - i - 1));            \
+      l->n--; t->n--; return 1;                                                         \
+    }                                                                                   \
+    name##_inner_t *in = (name##_inner_t*)nd;                                           \
+    i = name##__upper(in->keys, in->n, k);                                              \
+    if(!name##__del(t, in->child[i], h - 1, k)) return 0;                               \
+    name##__fix(t, in, i, h - 1);                                                       \
+    return 1; }                                                                         \
+  static inline int name##_erase(name##_t *t, ktype k) {                                \
+    if(t->root == NULL || !name##__del(t, t->root, t->height, k)) return 0;             \
+    if(t->height > 0 && ((name##_inner_t*)t->root)->n == 0) {                           \
+      void *old = t->root;                                                              \
+      t->root = ((name##_inner_t*)old)->child[0]; t->height--;                          \
+      name##__free(t, old);                                                             \
+    } else if(t->height == 0 && ((name##_leaf_t*)t->root)->n == 0) {                    \
+      name##__free(t, t->root); t->root = NULL;                                         \
+    }                                                                                   \
+    return 1; }                                                                         \
+  /* build from n strictly increasing keys, the tree must be empty */                   \
+  static inline const char* name##_bulk_load(name##_t *t, const ktype *keys,            \
+    const vtype *vals, size_t n) {                                                      \
+    size_t cnt, ng, done, per, extra, g, j, k;                                          \
+    void **nodes; ktype *mins;                                                          \
+    tsunlikely_if(t->root != NULL) return "BTREE NOT EMPTY";                            \
+    if(n == 0) return NULL;                                                             \
+    cnt = (n + name##_LCAP - 1) / name##_LCAP;                                          \
+    nodes = (void**)malloc(sizeof(void*) * cnt);                                        \
+    mins  = (ktype*)malloc(sizeof(ktype) * cnt);                                        \
+    tsunlikely_if(nodes == NULL || mins == NULL) goto oom;                              \
+    /* spread evenly so that every node is at least half full */                        \
+    per = n / cnt; extra = n % cnt;                                                     \
+    for(g = 0, done = 0 ; g < cnt ; ++g) {                                              \
+      name##_leaf_t *l = (name##_leaf_t*)name##__alloc(t);                              \
+      tsunlikely_if(l == NULL) goto oom;                                                \
+      l->n = per + (g < extra); l->next = NULL;                                         \
+      memcpy(l->keys, keys + done, sizeof(ktype) * l->n);                               \
+      memcpy(l->vals, vals + done, sizeof(vtype) * l->n);                               \
+      if(g > 0) ((name##_leaf_t*)nodes[g - 1])->next = l;                               \
+      nodes[g] = l; mins[g] = l->keys[0]; done += l->n;                                 \
+    }                                                                                   \
+    t->height = 0;                                                                      \
+    while(cnt > 1) {                                                                    \
+      ng = (cnt + name##_ICAP) / (name##_ICAP + 1);                                     \
+      per = cnt / ng; extra = cnt % ng;                                                 \
+      for(g = 0, done = 0 ; g < ng ; ++g) {                                             \
+        name##_inner_t *in = (name##_inner_t*)name##__alloc(t);                         \
+        tsunlikely_if(in == NULL) goto oom;                                             \
+        k = per + (g < extra);                                                          \
+        in->n = k - 1;                                                                  \
+        for(j = 0 ; j < k ; ++j) {                                                      \
+          in->child[j] = nodes[done + j];                                               \
+          if(j > 0) in->keys[j - 1] = mins[done + j];                                   \
+        }                                                                               \
+        mins[g] = mins[done]; nodes[g] = in; done += k;                                 \
+      }                                                                                 \
+      cnt = ng; t->height++;                                                            \
+    }                                                                                   \
+    t->root = nodes[0]; t->n = n;                                                       \
+    free(nodes); free(mins); return NULL;                                               \
+  oom:                                                                                  \
+    /* every node came from the tree's chunks, destroy drops the partial tree */        \
+    free(nodes); free(mins); name##_destroy(t); return "OOM"; }
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef TS_CHMAP_H__
+#define TS_CHMAP_H__
+
+#ifdef USE_TS_CHMAP
+
+#include <pthread.h>
+
+/// ts_chmap is a concurrent hash map made of nshards independent ts_hmap tables.
+/// each shard has its own reader-writer lock and sits on its own cache lines, so
+/// readers never contend with each other and writers only block the one shard they touch.
+/// (needs -pthread, hence it is opt-in with USE_TS_CHMAP like the pool allocators)
+
+// couple notes
+// 1. nshards must be a power of two. shard is picked from the top bits of the hash,
+//    the inner ts_hmap uses the low bits, so the two don't correlate.
+// 2. entries live inline in the shard's key / value arrays, there is no allocation per entry.
+// 3. readers take the shard's read lock instead of a seqlock retry loop. the inner table frees
+//    its arrays on resize, so an unlocked reader could touch freed memory mid-read.
+// 4. get copies the value out while the lock is held. Don't hand out pointers into a shard.
+// 5. bulk_load splits the shards across nthreads threads. every thread scans the whole input
+//    but only inserts keys of its own shards, so no locks are taken while loading.
+//    bulk_load must not run concurrently with other operations on the same map.
+
+#define TS_CHMAP_CACHELINE 64
+
+#define ts_make_chmap(name, ktype, vtype, hash_fn, eq_fn, nshards)                      \
+  ts_make_hmap(name##_shmap, ktype, vtype, hash_fn, eq_fn)                              \
+  typedef struct {                                                                      \
+    pthread_rwlock_t lock;                                                              \
+    name##_shmap_t   map;                                                               \
+  } __attribute__((aligned(TS_CHMAP_CACHELINE))) name##_shard_t;                        \
+  typedef struct { name##_shard_t shards[nshards]; } name##_t;                          \
+  static inline name##_shard_t* name##__shard(name##_t *h, uint64_t hash) {             \
+    return &h->shards[(size_t)(hash >> 48) & ((nshards) - 1)]; }                        \
+  static inline const char* name##_init(name##_t *h) {                                  \
+    for(size_t i = 0 ; i < (nshards) ; ++i) {                                           \
+      tsunlikely_if(pthread_rwlock_init(&h->shards[i].lock, NULL) != 0) {               \
+        while(i-- > 0) pthread_rwlock_destroy(&h->shards[i].lock);                      \
+        return "pthread_rwlock_init failed";                                            \
+      }                                                                                 \
+      name##_shmap_init(&h->shards[i].map);                                             \
+    }                                                                                   \
+    return NULL; }                                                                      \
+  static inline void name##_destroy(name##_t *h) {                                      \
+    for(size_t i = 0 ; i < (nshards) ; ++i) {                                           \
+      pthread_rwlock_destroy(&h->shards[i].lock);                                       \
+      name##_shmap_destroy(&h->shards[i].map);                                          \
+    } }                                                                                 \
+  static inline size_t name##_size(name##_t *h) {                                       \
+    size_t n = 0;                                                                       \
+    for(size_t i = 0 ; i < (nshards) ; ++i) {                                           \
+      pthread_rwlock_rdlock(&h->shards[i].lock);                                        \
+      n += h->shards[i].map.n;                                                          \
+      pthread_rwlock_unlock(&h->shards[i].lock);                                        \
+    }                                                                                   \
+    return n; }                                                                         \
+  static inline const char* name##_reserve(name##_t *h, size_t s) {                     \
+    const char *estr = NULL;                                                            \
+    for(size_t i = 0 ; i < (nshards) && estr == NULL ; ++i) {                           \
+      pthread_rwlock_wrlock(&h->shards[i].lock);                                        \
+      estr = name##_shmap_reserve(&h->shards[i].map, s / (nshards) + 1);                \
+      pthread_rwlock_unlock(&h->shards[i].lock);                                        \
+    }                                                                                   \
+    return estr; }                                                                      \
+  static inline int name##_get(name##_t *h, ktype key, vtype *ret) {                    \
+    name##_shard_t *s = name##__shard(h, (uint64_t)(hash_fn(key)));                     \
+    vtype *p;                                                                           \
+    pthread_rwlock_rdlock(&s->lock);                                                    \
+    if( (p = name##_shmap_get(&s->map, key)) != NULL && ret ) *ret = *p;                \
+    pthread_rwlock_unlock(&s->lock);                                                    \
+    return p != NULL; }                                                                 \
+  static inline const char* name##_put(name##_t *h, ktype key, vtype val) {             \
+    name##_shard_t *s = name##__shard(h, (uint64_t)(hash_fn(key)));                     \
+    const char *estr;                                                                   \
+    pthread_rwlock_wrlock(&s->lock);                                                    \
+    estr = name##_shmap_put(&s->map, key, val);                                         \
+    pthread_rwlock_unlock(&s->lock);                                                    \
+    return estr; }                                                                      \
+  static inline int name##_del(name##_t *h, ktype key) {                                \
+    name##_shard_t *s = name##__shard(h, (uint64_t)(hash_fn(key)));                     \
+    int ret;                                                                            \
+    pthread_rwlock_wrlock(&s->lock);                                                    \
+    ret = name##_shmap_del(&s->map, key);                                               \
+    pthread_rwlock_unlock(&s->lock);                                                    \
+    return ret; }                                                                       \
+  typedef struct {                                                                      \
+    name##_t *h; const ktype *keys; const vtype *vals; size_t n, tid, nthreads;         \
+    const char *estr;                                                                   \
+  } name##__bulk_arg_t;                                                                 \
+  static void* name##__bulk_worker(void *p) {                                           \
+    name##__bulk_arg_t *arg = (name##__bulk_arg_t *) p;                                 \
+    size_t shard;                                                                       \
+    for(size_t i = 0 ; i < arg->n && arg->estr == NULL ; ++i) {                         \
+      shard = (size_t)((uint64_t)(hash_fn(arg->keys[i])) >> 48) & ((nshards) - 1);      \
+      if(shard % arg->nthreads != arg->tid) continue;                                   \
+      arg->estr = name##_shmap_put(&arg->h->shards[shard].map,                          \
+        arg->keys[i], arg->vals[i]);                                                    \
+    }                                                                                   \
+    return NULL; }                                                                      \
+  static inline const char* name##_bulk_load(name##_t *h, const ktype *keys,            \
+    const vtype *vals, size_t n, size_t nthreads) {                                     \
+    const char *estr = NULL;                                                            \
+    if(nthreads == 0) nthreads = 1;                                                     \
+    if(nthreads > (nshards)) nthreads = (nshards);                                      \
+    pthread_t tids[nthreads];                                                           \
+    int started[nthreads];                                                              \
+    name##__bulk_arg_t args[nthreads];                                                  \
+    tsunlikely_if( (estr = name##_reserve(h, name##_size(h) + n)) != NULL )             \
+      return estr;                                                                      \
+    for(size_t t = 0 ; t < nthreads ; ++t) {                                            \
+      args[t] = (name##__bulk_arg_t){ h, keys, vals, n, t, nthreads, NULL };            \
+      started[t] = t > 0 &&                                                             \
+        pthread_create(&tids[t], NULL, name##__bulk_worker, &args[t]) == 0;             \
+    }                                                                                   \
+    /* whatever could not get its own thread is loaded by the caller */                 \
+    for(size_t t = 0 ; t < nthreads ; ++t)                                              \
+      if(!started[t]) name##__bulk_worker(&args[t]);                                    \
+    for(size_t t = 0 ; t < nthreads ; ++t) {                                            \
+      if(started[t]) pthread_join(tids[t], NULL);                                       \
+      if(args[t].estr && !estr) estr = args[t].estr;                                    \
+    }                                                                                   \
+    return estr; }
+
+#endif
+#endif
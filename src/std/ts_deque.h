@@ -0,0 +1,82 @@
+#ifndef TS_DEQUE_H__
+#define TS_DEQUE_H__
+
+/// ts_deque is a ring buffer generated with the same macro approach as ts_vec.
+/// capacity is always a power of two so wrapping an index is a mask instead of a modulo.
+/// push / pop at either end is O(1) (amortized when the buffer has to grow), which makes it
+/// suitable as a work queue where ts_vec's pushfront would be O(n).
+
+// CAUTION, same as ts_vec. if OOM happens in resize / push, you are responsible for cleaning up
+// the resources pointed by a[i]. The deque itself remains valid (and unchanged) on OOM.
+
+// segments(): the live elements are at most two contiguous runs of memory.
+// first run is a[head .. head+n1), second run is a[0 .. n2). Use this (or drain) to bulk copy
+// with memcpy instead of going through at() one element at a time.
+
+#define ts_make_deque(name, type)                                                       \
+  typedef struct { size_t head, n, m; type *a; } name##_t;                              \
+  static inline void name##_init(name##_t *v) { v->head = v->n = v->m = 0; v->a = 0; }  \
+  static inline void name##_destroy(name##_t *v) { free(v->a); }                        \
+  static inline void name##_clear(name##_t *v) { v->head = 0; v->n = 0; }               \
+  static inline size_t name##_size(name##_t *v) { return v->n; }                        \
+  static inline size_t name##_max(name##_t *v) { return v->m; }                         \
+  static inline type* name##_ptr(name##_t *v, size_t i) {                               \
+    return &v->a[(v->head + i) & (v->m - 1)]; }                                         \
+  static inline type name##_at(name##_t *v, size_t i) {                                 \
+    return v->a[(v->head + i) & (v->m - 1)]; }                                          \
+  static inline type name##_first(name##_t *v) { return v->a[v->head]; }                \
+  static inline type name##_last(name##_t *v) {                                         \
+    return v->a[(v->head + v->n - 1) & (v->m - 1)]; }                                   \
+  static inline void name##_segments(name##_t *v, type **p1, size_t *n1,                \
+    type **p2, size_t *n2) {                                                            \
+    size_t run = v->m - v->head;                                                        \
+    *p1 = v->a + v->head; *p2 = v->a;                                                   \
+    if(v->n <= run) { *n1 = v->n; *n2 = 0; }                                            \
+    else            { *n1 = run;  *n2 = v->n - run; }                                   \
+  }                                                                                     \
+  static inline const char* name##_resize(name##_t *v, size_t s) {                      \
+    type *tmp, *p1, *p2; size_t n1, n2, m = 4;                                          \
+    tsunlikely_if(s < v->n) return "SIZE SMALLER THAN CONTENT";                         \
+    while(m < s) m <<= 1;                                                               \
+    tsunlikely_if((tmp = (type*)malloc(sizeof(type) * m)) == NULL )                     \
+      return "OOM";                                                                     \
+    if(v->n) {                                                                          \
+      name##_segments(v, &p1, &n1, &p2, &n2);                                           \
+      memcpy(tmp, p1, sizeof(type) * n1);                                               \
+      memcpy(tmp + n1, p2, sizeof(type) * n2);                                          \
+    }                                                                                   \
+    free(v->a); v->a = tmp; v->m = m; v->head = 0; return NULL; }                       \
+  static inline const char* name##_compact(name##_t *v) {                               \
+    return name##_resize(v, v->n); }                                                    \
+  static inline const char* name##_push(name##_t *v, type x) {                          \
+    const char *estr;                                                                   \
+    if(v->n == v->m)                                                                    \
+      tsunlikely_if( (estr = name##_resize(v, v->m ? v->m << 1 : 4)) != NULL )          \
+        return estr;                                                                    \
+    v->a[(v->head + v->n++) & (v->m - 1)] = x; return NULL; }                           \
+  static inline const char* name##_pushfront(name##_t *v, type x) {                     \
+    const char *estr;                                                                   \
+    if(v->n == v->m)                                                                    \
+      tsunlikely_if( (estr = name##_resize(v, v->m ? v->m << 1 : 4)) != NULL )          \
+        return estr;                                                                    \
+    v->head = (v->head - 1) & (v->m - 1);                                               \
+    v->a[v->head] = x; v->n++; return NULL; }                                           \
+  static inline type name##_pop(name##_t *v) {                                          \
+    return v->a[(v->head + --(v->n)) & (v->m - 1)]; }                                   \
+  static inline type name##_popfront(name##_t *v) {                                     \
+    type x = v->a[v->head];                                                             \
+    v->head = (v->head + 1) & (v->m - 1); v->n--; return x; }                           \
+  static inline size_t name##_drain(name##_t *v, type *dst, size_t count) {             \
+    type *p1, *p2; size_t n1, n2;                                                       \
+    if(count > v->n) count = v->n;                                                      \
+    name##_segments(v, &p1, &n1, &p2, &n2);                                             \
+    if(count <= n1) {                                                                   \
+      memcpy(dst, p1, sizeof(type) * count);                                            \
+    } else {                                                                            \
+      memcpy(dst, p1, sizeof(type) * n1);                                               \
+      memcpy(dst + n1, p2, sizeof(type) * (count - n1));                                \
+    }                                                                                   \
+    v->head = (v->head + count) & (v->m - 1); v->n -= count;                            \
+    return count; }
+
+#endif
@@ -4,7 +4,15 @@
 const char * ts_strtol(long int* ret, const char * s, int base) {
   const char *estr = NULL;
   char *endptr;
-  
+  int64_t x;
+  size_t n;
+  
+  // plain base 10 numbers skip strtol, anything else keeps its semantics and error strings
+  if(base == 10 && (n = strlen(s)) != 0 && ts_parse_i64(s, n, &x) == n &&
+     x >= LONG_MIN && x <= LONG_MAX) {
+    *ret = (long int) x;
+    return NULL;
+  }
   errno = 0;
   *ret = strtol(s, &endptr, base);
   if(errno) return strerror(errno);
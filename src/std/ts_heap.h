@@ -0,0 +1,97 @@
+#ifndef TS_HEAP_H__
+#define TS_HEAP_H__
+
+/// ts_heap is a binary (or d-ary) min heap generated with the same macro approach as ts_vec.
+/// storage is the vec layout { n, m, a }, so a vec can be turned into a heap in place with
+/// ts_heap_from_vec + heapify in O(n) instead of pushing every element again.
+///
+/// less_fn(a, b) must return non-zero when a should come out of the heap before b.
+/// flip it to get a max heap.
+
+// decrease-key / remove of arbitrary elements:
+// ts_make_heap_ext takes pos_fn(type *elem, size_t idx), which is called every time an element
+// lands on a new index. store idx somewhere (usually inside the element itself),
+// change the element's key in place and call update(h, idx) to restore the heap.
+//
+// arity 4 halves the depth of the tree and keeps the 4 children of a node next to each other
+// in memory, so sift_down touches fewer cache lines. pop does more compares per level though,
+// it is usually a win once the heap no longer fits in L1.
+
+#define ts_heap_nopos(elem, idx) ((void)0)
+
+#define ts_heap_from_vec(h, v) do {                                                     \
+    (h).n = (v).n; (h).m = (v).m; (h).a = (v).a;                                        \
+    (v).n = (v).m = 0; (v).a = 0;                                                       \
+  } while(0)
+
+#define ts_make_heap(name, type, less_fn)                                               \
+  ts_make_heap_ext(name, type, less_fn, ts_heap_nopos, 2)
+
+#define ts_make_heap4(name, type, less_fn)                                              \
+  ts_make_heap_ext(name, type, less_fn, ts_heap_nopos, 4)
+
+#define ts_make_heap_ext(name, type, less_fn, pos_fn, arity)                            \
+  typedef struct { size_t n, m; type *a; } name##_t;                                    \
+  static inline void name##_init(name##_t *h) { h->n = 0; h->m = 0; h->a = 0; }         \
+  static inline void name##_destroy(name##_t *h) {                                      \
+    ts_vec_free(h->a, sizeof(type) * h->m); }                                           \
+  static inline void name##_clear(name##_t *h) { h->n = 0; }                            \
+  static inline size_t name##_size(name##_t *h) { return h->n; }                        \
+  static inline size_t name##_max(name##_t *h) { return h->m; }                         \
+  static inline type name##_top(name##_t *h) { return h->a[0]; }                        \
+  static inline type name##_at(name##_t *h, size_t i) { return h->a[i]; }               \
+  static inline type* name##_ptr(name##_t *h, size_t i) { return &h->a[i]; }            \
+  static inline const char* name##_resize(name##_t *h, size_t s) {                      \
+    type *tmp;                                                                          \
+    tmp = (type*)ts_vec_realloc(h->a, sizeof(type) * h->m, sizeof(type) * s);           \
+    tsunlikely_if(tmp == NULL)                                                          \
+      return "OOM";                                                                     \
+    h->m = s; h->a = tmp; return NULL; }                                                \
+  static inline void name##_sift_up(name##_t *h, size_t i) {                            \
+    type x = h->a[i]; size_t p;                                                         \
+    while(i > 0) {                                                                      \
+      p = (i - 1) / (arity);                                                            \
+      if(!(less_fn(x, h->a[p]))) break;                                                 \
+      h->a[i] = h->a[p]; pos_fn(&h->a[i], i);                                           \
+      i = p;                                                                            \
+    }                                                                                   \
+    h->a[i] = x; pos_fn(&h->a[i], i); }                                                 \
+  static inline void name##_sift_down(name##_t *h, size_t i) {                          \
+    type x = h->a[i]; size_t c, best, k;                                                \
+    for(;;) {                                                                           \
+      c = i * (arity) + 1;                                                              \
+      if(c >= h->n) break;                                                              \
+      best = c;                                                                         \
+      for(k = c + 1 ; k < c + (arity) && k < h->n ; ++k)                                \
+        if(less_fn(h->a[k], h->a[best])) best = k;                                      \
+      if(!(less_fn(h->a[best], x))) break;                                              \
+      h->a[i] = h->a[best]; pos_fn(&h->a[i], i);                                        \
+      i = best;                                                                         \
+    }                                                                                   \
+    h->a[i] = x; pos_fn(&h->a[i], i); }                                                 \
+  static inline void name##_heapify(name##_t *h) {                                      \
+    if(h->n > 1)                                                                        \
+      for(size_t i = (h->n - 2) / (arity) + 1 ; i-- > 0 ; )                             \
+        name##_sift_down(h, i);                                                         \
+    for(size_t i = 0 ; i < h->n ; ++i) pos_fn(&h->a[i], i); }                           \
+  static inline const char* name##_push(name##_t *h, type x) {                          \
+    const char *estr;                                                                   \
+    if(h->n == h->m) {                                                                  \
+      size_t m = h->m ? h->m << 1 : 4;                                                  \
+      tsunlikely_if( (estr = name##_resize(h, m)) != NULL )                             \
+        return estr;                                                                    \
+    }                                                                                   \
+    h->a[h->n++] = x; name##_sift_up(h, h->n - 1); return NULL; }                       \
+  static inline type name##_pop(name##_t *h) {                                          \
+    type x = h->a[0];                                                                   \
+    if(--(h->n) > 0) { h->a[0] = h->a[h->n]; name##_sift_down(h, 0); }                  \
+    return x; }                                                                         \
+  static inline void name##_update(name##_t *h, size_t i) {                             \
+    if(i > 0 && less_fn(h->a[i], h->a[(i - 1) / (arity)])) name##_sift_up(h, i);        \
+    else                                                     name##_sift_down(h, i); }  \
+  static inline type name##_remove(name##_t *h, size_t i) {                             \
+    type x = h->a[i];                                                                   \
+    if(i < --(h->n)) { h->a[i] = h->a[h->n]; name##_update(h, i); }                     \
+    return x; }
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef TS_HMAP_H__
+#define TS_HMAP_H__
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// ts_hmap is an open addressing hash map generated per key / value type (same approach as ts_vec).
+/// layout follows the swiss table idea: a separate array of control bytes, one per slot.
+/// a control byte is either TS_HMAP_EMPTY or the low 7 bits of the key's hash (h2).
+/// lookups compare 16 control bytes at once (SSE2 when available) and only touch
+/// keys whose h2 matches, so most misses never read the key array at all.
+
+// differences from a real swiss table:
+// 1. probing is linear at slot granularity (groups are just a 16 wide window from any slot)
+//    this is what allows deletion without tombstones: erase does a backward shift of the
+//    following run of the cluster, so the table never degrades after many deletes.
+// 2. keys, values and control bytes are three separate arrays.
+//
+// hash_fn(key) must return uint64_t, eq_fn(a, b) must return non-zero when a == b.
+// both are expanded inline in every instantiation, so they can be macros.
+// ts_hash_u64 / ts_hash_str / ts_hash_eq / ts_hash_str_eq are provided for the common cases.
+
+// CAUTION, the map stores keys / values by value. if they point to resources, you own them.
+
+#define TS_HMAP_EMPTY     ((uint8_t)0x80)
+#define TS_HMAP_GROUP     16
+#define TS_HMAP_MIN_CAP   16
+
+#define ts_hash_eq(a, b)      ((a) == (b))
+#define ts_hash_str_eq(a, b)  (strcmp((a), (b)) == 0)
+
+static inline uint64_t ts_hash_u64(uint64_t x) {
+  x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33; return x;
+}
+
+static inline uint64_t ts_hash_bytes(const void *data, size_t n) {
+  const uint8_t *p = (const uint8_t *) data;
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ n, w;
+  for( ; n >= 8 ; n -= 8, p += 8) {
+    memcpy(&w, p, 8);
+    h ^= w * 0x87c37b91114253d5ULL;
+    h  = ((h << 31) | (h >> 33)) * 0x4cf5ad432745937fULL;
+  }
+  w = 0;
+  memcpy(&w, p, n);
+  return ts_hash_u64(h ^ w);
+}
+
+static inline uint64_t ts_hash_str(const char *s) {
+  return ts_hash_bytes(s, strlen(s));
+}
+
+// bitmask of the slots in ctrl[0..16) whose control byte equals c
+static inline uint32_t ts_hmap_match(const uint8_t *ctrl, uint8_t c) {
+#if defined(__SSE2__)
+  __m128i g = _mm_loadu_si128((const __m128i *) ctrl);
+  return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char) c)));
+#else
+  uint32_t bits = 0;
+  for(int i = 0 ; i < TS_HMAP_GROUP ; i++)
+    bits |= (uint32_t)(ctrl[i] == c) << i;
+  return bits;
+#endif
+}
+
+#define ts_hmap_exists(h, i)  ((h).ctrl[(i)] != TS_HMAP_EMPTY)
+#define ts_hmap_key(h, i)     ((h).keys[(i)])
+#define ts_hmap_val(h, i)     ((h).vals[(i)])
+#define ts_hmap_end(h)        ((h).m)
+#define ts_hmap_foreach(h, iter)                                                        \
+  for ( size_t iter = 0 ; iter < (h).m ; ++iter)                                        \
+    if( !ts_hmap_exists(h, iter) ) {} else
+
+#define ts_make_hmap(name, ktype, vtype, hash_fn, eq_fn)                                \
+  typedef struct { size_t n, m; uint8_t *ctrl; ktype *keys; vtype *vals; } name##_t;    \
+  static inline void name##_init(name##_t *h) {                                         \
+    h->n = h->m = 0; h->ctrl = 0; h->keys = 0; h->vals = 0; }                           \
+  static inline void name##_destroy(name##_t *h) {                                      \
+    free(h->ctrl); free(h->keys); free(h->vals); }                                      \
+  static inline void name##_clear(name##_t *h) {                                        \
+    if(h->ctrl) memset(h->ctrl, TS_HMAP_EMPTY, h->m + TS_HMAP_GROUP);                   \
+    h->n = 0; }                                                                         \
+  static inline size_t name##_size(name##_t *h) { return h->n; }                        \
+  static inline size_t name##_max(name##_t *h) { return h->m; }                         \
+  static inline void name##__set_ctrl(name##_t *h, size_t i, uint8_t c) {               \
+    h->ctrl[i] = c;                                                                     \
+    if(i < TS_HMAP_GROUP) h->ctrl[h->m + i] = c; }                                      \
+  static inline size_t name##__find_empty(name##_t *h, uint64_t hash) {                 \
+    size_t mask = h->m - 1, pos = (size_t)(hash >> 7) & mask;                           \
+    uint32_t bits;                                                                      \
+    while( (bits = ts_hmap_match(h->ctrl + pos, TS_HMAP_EMPTY)) == 0 )                  \
+      pos = (pos + TS_HMAP_GROUP) & mask;                                               \
+    return (pos + __builtin_ctz(bits)) & mask; }                                        \
+  static inline size_t name##__find(name##_t *h, ktype key, uint64_t hash) {            \
+    size_t mask = h->m - 1, pos = (size_t)(hash >> 7) & mask, i;                        \
+    uint8_t h2 = (uint8_t)(hash & 0x7f);                                                \
+    uint32_t bits;                                                                      \
+    tsunlikely_if(h->m == 0) return 0;                                                  \
+    for(;;) {                                                                           \
+      bits = ts_hmap_match(h->ctrl + pos, h2);                                          \
+      while(bits) {                                                                     \
+        i = (pos + __builtin_ctz(bits)) & mask;                                         \
+        tslikely_if(eq_fn(h->keys[i], key)) return i;                                   \
+        bits &= bits - 1;                                                               \
+      }                                                                                 \
+      tslikely_if(ts_hmap_match(h->ctrl + pos, TS_HMAP_EMPTY)) return h->m;             \
+      pos = (pos + TS_HMAP_GROUP) & mask;                                               \
+    } }                                                                                 \
+  static inline size_t name##_find(name##_t *h, ktype key) {                            \
+    return name##__find(h, key, (uint64_t)(hash_fn(key))); }                            \
+  static inline vtype* name##_get(name##_t *h, ktype key) {                             \
+    size_t i = name##_find(h, key);                                                     \
+    return i == h->m ? NULL : &h->vals[i]; }                                            \
+  static inline const char* name##_resize(name##_t *h, size_t s) {                      \
+    name##_t nh; size_t m = TS_HMAP_MIN_CAP, i, j;                                      \
+    while(m - (m >> 3) < s) m <<= 1;                                                    \
+    tsunlikely_if(s < h->n) return "SIZE SMALLER THAN CONTENT";                         \
+    nh.n = h->n; nh.m = m;                                                              \
+    nh.ctrl = (uint8_t*)malloc(m + TS_HMAP_GROUP);                                      \
+    nh.keys = (ktype*)malloc(sizeof(ktype) * m);                                        \
+    nh.vals = (vtype*)malloc(sizeof(vtype) * m);                                        \
+    tsunlikely_if(nh.ctrl == NULL || nh.keys == NULL || nh.vals == NULL) {              \
+      name##_destroy(&nh); return "OOM"; }                                              \
+    memset(nh.ctrl, TS_HMAP_EMPTY, m + TS_HMAP_GROUP);                                  \
+    for(i = 0 ; i < h->m ; ++i) {                                                       \
+      if(h->ctrl[i] == TS_HMAP_EMPTY) continue;                                         \
+      uint64_t hash = (uint64_t)(hash_fn(h->keys[i]));                                  \
+      j = name##__find_empty(&nh, hash);                                                \
+      name##__set_ctrl(&nh, j, (uint8_t)(hash & 0x7f));                                 \
+      nh.keys[j] = h->keys[i]; nh.vals[j] = h->vals[i];                                 \
+    }                                                                                   \
+    name##_destroy(h); *h = nh; return NULL; }                                          \
+  static inline const char* name##_reserve(name##_t *h, size_t s) {                     \
+    if(s <= h->m - (h->m >> 3)) return NULL;                                            \
+    return name##_resize(h, s); }                                                       \
+  static inline const char* name##_put_ptr(name##_t *h, ktype key,                      \
+    vtype **ret, int *absent) {                                                         \
+    const char *estr;                                                                   \
+    uint64_t hash = (uint64_t)(hash_fn(key));                                           \
+    size_t i = name##__find(h, key, hash);                                              \
+    if(i < h->m) { *ret = &h->vals[i]; if(absent) *absent = 0; return NULL; }           \
+    if(h->n + 1 > h->m - (h->m >> 3))                                                   \
+      tsunlikely_if( (estr = name##_resize(h, h->n + 1)) != NULL )                      \
+        return estr;                                                                    \
+    i = name##__find_empty(h, hash);                                                    \
+    name##__set_ctrl(h, i, (uint8_t)(hash & 0x7f));                                     \
+    h->keys[i] = key; h->n++;                                                           \
+    *ret = &h->vals[i]; if(absent) *absent = 1; return NULL; }                          \
+  static inline const char* name##_put(name##_t *h, ktype key, vtype val) {             \
+    const char *estr; vtype *p;                                                         \
+    tsunlikely_if( (estr = name##_put_ptr(h, key, &p, NULL)) != NULL )                  \
+      return estr;                                                                      \
+    *p = val; return NULL; }                                                            \
+  static inline void name##_erase(name##_t *h, size_t i) {                              \
+    size_t mask = h->m - 1, j = i, k;                                                   \
+    for(;;) {                                                                           \
+      j = (j + 1) & mask;                                                               \
+      if(h->ctrl[j] == TS_HMAP_EMPTY) break;                                            \
+      k = (size_t)((uint64_t)(hash_fn(h->keys[j])) >> 7) & mask;                        \
+      /* j may fill the hole at i only if its home slot k is not within (i, j] */       \
+      if( i <= j ? (i < k && k <= j) : (i < k || k <= j) ) continue;                    \
+      name##__set_ctrl(h, i, h->ctrl[j]);                                               \
+      h->keys[i] = h->keys[j]; h->vals[i] = h->vals[j];                                 \
+      i = j;                                                                            \
+    }                                                                                   \
+    name##__set_ctrl(h, i, TS_HMAP_EMPTY); h->n--; }                                    \
+  static inline int name##_del(name##_t *h, ktype key) {                                \
+    size_t i = name##_find(h, key);                                                     \
+    if(i == h->m) return 0;                                                             \
+    name##_erase(h, i); return 1; }
+
+#endif
@@ -673,4 +673,25 @@ void ts_hpool_attach(ts_hpool_t *heap, void *ptr, void *parent) {
 
 
 
+static void * ts_hpool_sds_malloc(void *ctx, size_t size) {
+  return ts_hpool_malloc((ts_hpool_t *) ctx, size);
+}
+
+static void * ts_hpool_sds_realloc(void *ctx, void *ptr, size_t oldsize, size_t size) {
+  (void) oldsize;
+  return ts_hpool_realloc((ts_hpool_t *) ctx, ptr, size);
+}
+
+static void ts_hpool_sds_free(void *ctx, void *ptr, size_t size) {
+  (void) size;
+  ts_hpool_free((ts_hpool_t *) ctx, ptr);
+}
+
+void ts_hpool_sdsalloc(sdsallocator *sa, ts_hpool_t *heap) {
+  sa->malloc  = ts_hpool_sds_malloc;
+  sa->realloc = ts_hpool_sds_realloc;
+  sa->free    = ts_hpool_sds_free;
+  sa->ctx     = heap;
+}
+
 #endif
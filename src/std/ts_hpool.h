@@ -17,5 +17,8 @@ TSC_EXTERN void *       ts_hpool_realloc(ts_hpool_t *heap, void *ptr, size_t siz
 TSC_EXTERN void         ts_hpool_attach(ts_hpool_t *heap, void *ptr, void *parent);
 TSC_EXTERN void *       ts_hpool_info(ts_hpool_t *heap, void *ptr);
 
+// fills *sa so sdsnewlen_a(sa, ...) places strings in the hpool. sa must outlive them.
+TSC_EXTERN void         ts_hpool_sdsalloc(sdsallocator *sa, ts_hpool_t *heap);
+
 #endif
 #endif
@@ -0,0 +1,123 @@
+#include "libts.h"
+
+static inline void ts_intern_lock(ts_intern_t *t) {
+  if(!t->mt) return;
+  while(__atomic_exchange_n(&t->lock, 1, __ATOMIC_ACQUIRE))
+    while(__atomic_load_n(&t->lock, __ATOMIC_RELAXED)) sched_yield();
+}
+
+static inline void ts_intern_unlock(ts_intern_t *t) {
+  if(t->mt) __atomic_store_n(&t->lock, 0, __ATOMIC_RELEASE);
+}
+
+const char * ts_intern_init(ts_intern_t *t, int threadsafe) {
+  memset(t, 0, sizeof(*t));
+  ts_intern_map_init(&t->map);
+  t->mt = threadsafe;
+  return NULL;
+}
+
+void ts_intern_destroy(ts_intern_t *t) {
+  for(size_t i = 0 ; i < t->nchunks ; i++) free(t->chunks[i]);
+  free(t->chunks);
+  free(t->strs);
+  ts_intern_map_destroy(&t->map);
+  memset(t, 0, sizeof(*t));
+}
+
+static const char * ts_intern_chunk(ts_intern_t *t, size_t sz, char **ret) {
+  if(t->nchunks == t->mchunks) {
+    size_t m = t->mchunks ? t->mchunks << 1 : 8;
+    char **c = (char **) realloc(t->chunks, m * sizeof(char *));
+    tsunlikely_if(c == NULL) return "OOM";
+    t->chunks  = c;
+    t->mchunks = m;
+  }
+  tsunlikely_if( (*ret = (char *) malloc(sz)) == NULL )
+    return "OOM";
+  t->chunks[t->nchunks++] = *ret;
+  return NULL;
+}
+
+// [id u32 | len u32 | bytes | NUL], entries are 4 byte aligned.
+// a string over half a chunk gets an allocation of its own, the current chunk stays open.
+static const char * ts_intern_copy(ts_intern_t *t, const char *s, size_t n, char **ret) {
+  const char *estr;
+  size_t      need = (8 + n + 1 + 3) & ~(size_t)3;
+  uint32_t    id = (uint32_t) t->map.n, len = (uint32_t) n;
+  char       *p;
+
+  if(need > TS_INTERN_CHUNK / 2) {
+    tsunlikely_if( (estr = ts_intern_chunk(t, need, &p)) != NULL )
+      return estr;
+  } else {
+    if((size_t)(t->end - t->cur) < need) {
+      tsunlikely_if( (estr = ts_intern_chunk(t, TS_INTERN_CHUNK, &t->cur)) != NULL )
+        return estr;
+      t->end = t->cur + TS_INTERN_CHUNK;
+    }
+    p       = t->cur;
+    t->cur += need;
+  }
+  memcpy(p, &id, 4);
+  memcpy(p + 4, &len, 4);
+  memcpy(p + 8, s, n);
+  p[8 + n] = '\0';
+  *ret = p + 8;
+  return NULL;
+}
+
+static const char * ts_intern_locked(ts_intern_t *t, const char *s, size_t n,
+                                     const char **ret) {
+  const char *estr;
+  char       *p;
+  uint32_t   *id;
+  size_t      i = ts_intern_map_find(&t->map, ts_sv(s, n));
+
+  if(i < t->map.m) {
+    *ret = t->map.keys[i].p;
+    return NULL;
+  }
+  tsunlikely_if(n > UINT32_MAX || t->map.n >= UINT32_MAX) return "INTERN TABLE FULL";
+  if(t->map.n == t->mstrs) {
+    size_t       m = t->mstrs ? t->mstrs << 1 : 64;
+    const char **a = (const char **) realloc((void *) t->strs, m * sizeof(char *));
+    tsunlikely_if(a == NULL) return "OOM";
+    t->strs  = a;
+    t->mstrs = m;
+  }
+  tsunlikely_if( (estr = ts_intern_copy(t, s, n, &p)) != NULL )
+    return estr;
+  tsunlikely_if( (estr = ts_intern_map_put_ptr(&t->map, ts_sv(p, n), &id, NULL)) != NULL )
+    return estr;
+  *id = (uint32_t)(t->map.n - 1);
+  t->strs[*id] = p;
+  *ret = p;
+  return NULL;
+}
+
+const char * ts_intern(ts_intern_t *t, const char *s, size_t n, const char **ret) {
+  const char *estr;
+  ts_intern_lock(t);
+  estr = ts_intern_locked(t, s, n, ret);
+  ts_intern_unlock(t);
+  return estr;
+}
+
+const char * ts_intern_find(ts_intern_t *t, const char *s, size_t n) {
+  size_t      i;
+  const char *p = NULL;
+  ts_intern_lock(t);
+  i = ts_intern_map_find(&t->map, ts_sv(s, n));
+  if(i < t->map.m) p = t->map.keys[i].p;
+  ts_intern_unlock(t);
+  return p;
+}
+
+const char * ts_intern_str(ts_intern_t *t, uint32_t id) {
+  const char *p = NULL;
+  ts_intern_lock(t);
+  if(id < t->map.n) p = t->strs[id];
+  ts_intern_unlock(t);
+  return p;
+}
@@ -0,0 +1,61 @@
+#ifndef TS_INTERN_H__
+#define TS_INTERN_H__
+
+#include <sched.h>
+
+/// ts_intern_t maps byte strings to one canonical, NUL terminated copy, so equal strings get
+/// the same pointer and comparing them is a pointer compare. every string also gets a dense
+/// 32-bit id (0, 1, 2 ... in insertion order).
+///
+///   const char *name;
+///   ts_intern(&tab, field, len, &name);       // lookup or insert
+///   if(name == known_name) ...
+///
+/// the copies live in an arena of TS_INTERN_CHUNK byte chunks that never move, pointers stay
+/// valid until ts_intern_destroy. each copy is preceded by its id and length, so
+/// ts_intern_id / ts_intern_len are a load, no table lookup.
+
+// the index is a ts_hmap keyed by views into the arena.
+// init(t, 1) makes ts_intern / ts_intern_find / ts_intern_str safe to call from several threads,
+// they then take a spinlock (yielding) around the table. ts_intern_id / ts_intern_len
+// never need it.
+
+#define TS_INTERN_CHUNK 65536
+
+static inline uint64_t ts_intern_hash(ts_strview_t v) { return ts_hash_bytes(v.p, v.n); }
+
+ts_make_hmap(ts_intern_map, ts_strview_t, uint32_t, ts_intern_hash, ts_sv_eq)
+
+typedef struct {
+  ts_intern_map_t map;
+  const char    **strs;       // id -> string
+  size_t          mstrs;
+  char          **chunks;
+  size_t          nchunks, mchunks;
+  char           *cur, *end;  // free space in the current chunk
+  int             mt;
+  int             lock;
+} ts_intern_t;
+
+TSC_EXTERN const char * ts_intern_init(ts_intern_t *t, int threadsafe);
+TSC_EXTERN void         ts_intern_destroy(ts_intern_t *t);
+TSC_EXTERN const char * ts_intern(ts_intern_t *t, const char *s, size_t n, const char **ret);
+TSC_EXTERN const char * ts_intern_find(ts_intern_t *t, const char *s, size_t n);
+TSC_EXTERN const char * ts_intern_str(ts_intern_t *t, uint32_t id);
+
+static inline size_t ts_intern_size(ts_intern_t *t) { return t->map.n; }
+
+// p must come from ts_intern / ts_intern_find / ts_intern_str
+static inline uint32_t ts_intern_id(const char *p) {
+  uint32_t id;
+  memcpy(&id, p - 8, sizeof(id));
+  return id;
+}
+
+static inline size_t ts_intern_len(const char *p) {
+  uint32_t n;
+  memcpy(&n, p - 4, sizeof(n));
+  return n;
+}
+
+#endif
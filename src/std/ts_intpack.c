@@ -0,0 +1,226 @@
+#include "libts.h"
+
+// block layout for width b (1..32): b words of 16 bytes. value i of the block goes to lane
+// i % 4, and each lane is a little endian bit stream of 32 values * b bits.
+// so word w lane l holds bits [32w, 32w + 32) of lane l, and one SSE2 shift extracts
+// 4 consecutive values at once.
+
+static inline unsigned ts_pack_width(uint64_t x) {
+  return x ? 64 - (unsigned)__builtin_clzll(x) : 0;
+}
+
+static void ts_pack_bits(uint8_t *dst, const uint32_t *d, unsigned b) {
+  uint32_t words[4 * 32];
+  unsigned bit, wi, off;
+  memset(words, 0, sizeof(uint32_t) * 4 * b);
+  for(unsigned l = 0 ; l < 4 ; l++) {
+    bit = 0;
+    for(unsigned k = 0 ; k < 32 ; k++, bit += b) {
+      wi = bit >> 5; off = bit & 31;
+      words[wi * 4 + l] |= d[k * 4 + l] << off;
+      if(off + b > 32)
+        words[(wi + 1) * 4 + l] |= d[k * 4 + l] >> (32 - off);
+    }
+  }
+  memcpy(dst, words, sizeof(uint32_t) * 4 * b);
+}
+
+#if defined(__SSE2__)
+static void ts_pack_unbits(uint32_t *d, const uint8_t *src, unsigned b) {
+  const __m128i *in   = (const __m128i *) src;
+  const __m128i  mask = _mm_set1_epi32(b == 32 ? -1 : (int)((1u << b) - 1));
+  __m128i acc, v;
+  unsigned off = 0;
+  if(b == 0) { memset(d, 0, sizeof(uint32_t) * TS_PACK_BLOCK); return; }
+  acc = _mm_loadu_si128(in++);
+  for(unsigned k = 0 ; k < 32 ; k++) {
+    v = _mm_srl_epi32(acc, _mm_cvtsi32_si128((int) off));
+    if(off + b > 32) {
+      acc = _mm_loadu_si128(in++);
+      v   = _mm_or_si128(v, _mm_sll_epi32(acc, _mm_cvtsi32_si128((int)(32 - off))));
+      off = off + b - 32;
+    } else if( (off += b) == 32 && k < 31 ) {
+      acc = _mm_loadu_si128(in++);
+      off = 0;
+    }
+    _mm_storeu_si128((__m128i *)(d + 4 * k), _mm_and_si128(v, mask));
+  }
+}
+#else
+static void ts_pack_unbits(uint32_t *d, const uint8_t *src, unsigned b) {
+  uint32_t words[4 * 32], mask = b == 32 ? 0xffffffffu : (1u << b) - 1, v;
+  unsigned bit, wi, off;
+  if(b == 0) { memset(d, 0, sizeof(uint32_t) * TS_PACK_BLOCK); return; }
+  memcpy(words, src, sizeof(uint32_t) * 4 * b);
+  for(unsigned l = 0 ; l < 4 ; l++) {
+    bit = 0;
+    for(unsigned k = 0 ; k < 32 ; k++, bit += b) {
+      wi = bit >> 5; off = bit & 31;
+      v  = words[wi * 4 + l] >> off;
+      if(off + b > 32)
+        v |= words[(wi + 1) * 4 + l] << (32 - off);
+      d[k * 4 + l] = v & mask;
+    }
+  }
+}
+#endif
+
+const char * ts_pack_init(ts_pack_t *p) {
+  memset(p, 0, sizeof(*p));
+  tsunlikely_if( (p->data = sdsempty()) == NULL )
+    return "OOM";
+  return NULL;
+}
+
+void ts_pack_destroy(ts_pack_t *p) {
+  sdsfree(p->data);
+  free(p->first);
+  free(p->offset);
+  memset(p, 0, sizeof(*p));
+}
+
+static const char * ts_pack_block(ts_pack_t *p, const uint64_t *a, size_t k) {
+  uint64_t  delta[TS_PACK_BLOCK] = {0}, maxd = 0;
+  uint32_t  d32[TS_PACK_BLOCK];
+  unsigned  b;
+  size_t    len;
+  sds       tmp;
+
+  for(size_t i = 1 ; i < k ; i++) {
+    delta[i] = a[i] - a[i - 1];
+    maxd    |= delta[i];
+  }
+  if(p->nblocks == p->mblocks) {
+    size_t    m = p->mblocks ? p->mblocks << 1 : 4;
+    uint64_t *f = (uint64_t *) realloc(p->first, sizeof(uint64_t) * m);
+    tsunlikely_if(f == NULL) return "OOM";
+    p->first = f;
+    size_t   *o = (size_t *) realloc(p->offset, sizeof(size_t) * m);
+    tsunlikely_if(o == NULL) return "OOM";
+    p->offset  = o;
+    p->mblocks = m;
+  }
+
+  b   = ts_pack_width(maxd);
+  b   = b > 32 ? TS_PACK_RAW : b;
+  len = 1 + (b == TS_PACK_RAW ? sizeof(delta) : (size_t) 16 * b);
+  tsunlikely_if( (tmp = sdsMakeRoomFor(p->data, len)) == NULL )
+    return "OOM";
+  p->data = tmp;
+
+  uint8_t *dst = (uint8_t *) p->data + sdslen(p->data);
+  dst[0] = (uint8_t) b;
+  if(b == TS_PACK_RAW) {
+    memcpy(dst + 1, delta, sizeof(delta));
+  } else {
+    for(size_t i = 0 ; i < TS_PACK_BLOCK ; i++) d32[i] = (uint32_t) delta[i];
+    ts_pack_bits(dst + 1, d32, b);
+  }
+  sdsIncrLen(p->data, (int) len);
+
+  p->offset[p->nblocks] = sdslen(p->data) - len;
+  p->first[p->nblocks]  = a[0];
+  p->nblocks++;
+  p->n   += k;
+  p->last = a[k - 1];
+  return NULL;
+}
+
+// the whole input is checked before any block is written, and blocks written before an
+// OOM are dropped again, so a failed append leaves p unchanged
+const char * ts_pack_append(ts_pack_t *p, const uint64_t *a, size_t n) {
+  const char *estr;
+  size_t      nblocks = p->nblocks, cnt = p->n, len = sdslen(p->data);
+  uint64_t    last = p->last;
+  if(n == 0) return NULL;
+  tsunlikely_if(p->n % TS_PACK_BLOCK) return "PACK LAST BLOCK IS PARTIAL";
+  tsunlikely_if(p->n && a[0] < p->last) return "INPUT NOT SORTED";
+  for(size_t i = 1 ; i < n ; i++)
+    tsunlikely_if(a[i] < a[i - 1]) return "INPUT NOT SORTED";
+  for(size_t i = 0 ; i < n ; i += TS_PACK_BLOCK) {
+    size_t k = n - i < TS_PACK_BLOCK ? n - i : TS_PACK_BLOCK;
+    tsunlikely_if( (estr = ts_pack_block(p, a + i, k)) != NULL ) {
+      p->nblocks = nblocks;
+      p->n       = cnt;
+      p->last    = last;
+      sdssetlen(p->data, len);
+      p->data[len] = '\0';
+      return estr;
+    }
+  }
+  return NULL;
+}
+
+size_t ts_pack_decode_block(const ts_pack_t *p, size_t blk, uint64_t *out) {
+  const uint8_t *src = (const uint8_t *) p->data + p->offset[blk];
+  size_t   k   = blk + 1 < p->nblocks ? TS_PACK_BLOCK : p->n - blk * TS_PACK_BLOCK;
+  uint64_t cur = p->first[blk];
+
+  if(src[0] == TS_PACK_RAW) {
+    uint64_t delta[TS_PACK_BLOCK];
+    memcpy(delta, src + 1, sizeof(delta));
+    for(size_t i = 0 ; i < k ; i++) out[i] = (cur += delta[i]);
+  } else {
+    uint32_t delta[TS_PACK_BLOCK];
+    ts_pack_unbits(delta, src + 1, src[0]);
+    for(size_t i = 0 ; i < k ; i++) out[i] = (cur += delta[i]);
+  }
+  return k;
+}
+
+void ts_pack_decode(const ts_pack_t *p, uint64_t *out) {
+  for(size_t b = 0 ; b < p->nblocks ; b++)
+    out += ts_pack_decode_block(p, b, out);
+}
+
+uint64_t ts_pack_get(const ts_pack_t *p, size_t i) {
+  uint64_t tmp[TS_PACK_BLOCK];
+  ts_pack_decode_block(p, i / TS_PACK_BLOCK, tmp);
+  return tmp[i % TS_PACK_BLOCK];
+}
+
+size_t ts_pack_lower_bound(const ts_pack_t *p, uint64_t x) {
+  uint64_t tmp[TS_PACK_BLOCK];
+  size_t   lo = 0, hi = p->nblocks, mid, k, i;
+
+  // first block starting at >= x, the answer is in the block before it or at its start
+  while(lo < hi) {
+    mid = (lo + hi) >> 1;
+    if(p->first[mid] < x) lo = mid + 1; else hi = mid;
+  }
+  if(lo == 0) return 0;
+  k = ts_pack_decode_block(p, lo - 1, tmp);
+  for(i = 0 ; i < k && tmp[i] < x ; i++);
+  return (lo - 1) * TS_PACK_BLOCK + i;
+}
+
+size_t ts_pack_bytes(const ts_pack_t *p) {
+  return sdslen(p->data) + p->nblocks * (sizeof(uint64_t) + sizeof(size_t));
+}
+
+sds ts_varint_encode(sds s, const uint64_t *a, size_t n, int delta) {
+  uint64_t prev = 0;
+  for(size_t i = 0 ; i < n ; i++) {
+    tsunlikely_if( (s = sdsMakeRoomFor(s, 10)) == NULL )
+      return NULL;
+    sdsIncrLen(s, (int) ts_varint_put((uint8_t *) s + sdslen(s), delta ? a[i] - prev : a[i]));
+    prev = a[i];
+  }
+  return s;
+}
+
+const char * ts_varint_decode(uint64_t *out, size_t n, const uint8_t *src, size_t len,
+                              size_t *used, int delta) {
+  const uint8_t *p = src, *end = src + len;
+  uint64_t       x, prev = 0;
+  size_t         k;
+  for(size_t i = 0 ; i < n ; i++) {
+    tsunlikely_if( (k = ts_varint_get(p, end, &x)) == 0 )
+      return "VARINT TRUNCATED";
+    p     += k;
+    prev   = delta ? prev + x : x;
+    out[i] = prev;
+  }
+  if(used) *used = (size_t)(p - src);
+  return NULL;
+}
@@ -0,0 +1,101 @@
+#ifndef TS_INTPACK_H__
+#define TS_INTPACK_H__
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// compressed storage for sorted integer lists (posting lists, offsets, ids).
+///
+/// ts_pack_t: blocks of TS_PACK_BLOCK values, each block stores the deltas to the previous
+/// value bit-packed with the smallest width that fits the block (frame of reference).
+/// the bits are laid out in 4 interleaved 32-bit lanes, so decoding a block is a run of
+/// SSE2 shift / and over 16 byte words (scalar decode without SSE2).
+/// a skip index (first value + byte offset of every block) gives random access by block,
+/// ts_pack_lower_bound only decodes the one block the value can be in.
+///
+/// ts_varint_*: LEB128, 7 bits per byte. for streams / small lists where blocks are too coarse.
+
+// blocks whose deltas need more than 32 bits are stored raw (width byte TS_PACK_RAW).
+// no patched exceptions (PFor), one large gap widens only its own block.
+// the last block is padded to a full block, a list costs at least one block.
+
+#define TS_PACK_BLOCK 128
+#define TS_PACK_RAW   64
+
+typedef struct {
+  size_t    n;          // number of values
+  size_t    nblocks, mblocks;
+  uint64_t *first;      // skip index: first value of each block
+  size_t   *offset;     // skip index: byte offset of each block in data
+  uint64_t  last;
+  sds       data;       // [width byte | packed deltas] per block
+} ts_pack_t;
+
+TSC_EXTERN const char * ts_pack_init(ts_pack_t *p);
+TSC_EXTERN void         ts_pack_destroy(ts_pack_t *p);
+TSC_EXTERN const char * ts_pack_append(ts_pack_t *p, const uint64_t *a, size_t n);
+TSC_EXTERN size_t       ts_pack_decode_block(const ts_pack_t *p, size_t blk, uint64_t *out);
+TSC_EXTERN void         ts_pack_decode(const ts_pack_t *p, uint64_t *out);
+TSC_EXTERN uint64_t     ts_pack_get(const ts_pack_t *p, size_t i);
+TSC_EXTERN size_t       ts_pack_lower_bound(const ts_pack_t *p, uint64_t x);
+TSC_EXTERN size_t       ts_pack_bytes(const ts_pack_t *p);
+
+static inline size_t ts_pack_size(const ts_pack_t *p) { return p->n; }
+
+TSC_EXTERN sds          ts_varint_encode(sds s, const uint64_t *a, size_t n, int delta);
+TSC_EXTERN const char * ts_varint_decode(uint64_t *out, size_t n, const uint8_t *src,
+                                         size_t len, size_t *used, int delta);
+
+// writes x to dst (up to 10 bytes), returns the number of bytes written
+static inline size_t ts_varint_put(uint8_t *dst, uint64_t x) {
+  size_t i = 0;
+  while(x >= 0x80) {
+    dst[i++] = (uint8_t)(x | 0x80);
+    x >>= 7;
+  }
+  dst[i++] = (uint8_t) x;
+  return i;
+}
+
+// reads one value from [p, end), returns the number of bytes read, 0 if truncated / too long
+static inline size_t ts_varint_get(const uint8_t *p, const uint8_t *end, uint64_t *x) {
+  uint64_t v = 0;
+  for(size_t i = 0 ; i < 10 && p + i < end ; ++i) {
+    v |= (uint64_t)(p[i] & 0x7f) << (7 * i);
+    if(p[i] < 0x80) { *x = v; return i + 1; }
+  }
+  return 0;
+}
+
+// ts_make_vec_pack(name, type) adds to a sorted integer vec made with ts_make_vec(name, type):
+//   name##_pack(v, p)     append v to the (initialized) pack p
+//   name##_unpack(v, p)   decode p into v (v is resized, previous content dropped)
+// signed types are stored with the sign bit flipped, which keeps negative values in order.
+#define ts_make_vec_pack(name, type)                                                    \
+  static inline uint64_t name##__pack_flip(void) {                                      \
+    return (type)-1 < (type)1 ? (uint64_t)1 << (sizeof(type) * 8 - 1) : 0; }            \
+  static inline const char* name##_pack(name##_t *v, ts_pack_t *p) {                    \
+    const char *estr; uint64_t tmp[TS_PACK_BLOCK], flip = name##__pack_flip();          \
+    uint64_t mask = ~(uint64_t)0 >> (64 - sizeof(type) * 8);                            \
+    for(size_t i = 0 ; i < v->n ; i += TS_PACK_BLOCK) {                                 \
+      size_t k = v->n - i < TS_PACK_BLOCK ? v->n - i : TS_PACK_BLOCK;                   \
+      for(size_t j = 0 ; j < k ; ++j)                                                   \
+        tmp[j] = ((uint64_t)v->a[i + j] ^ flip) & mask;                                 \
+      tsunlikely_if( (estr = ts_pack_append(p, tmp, k)) != NULL )                       \
+        return estr;                                                                    \
+    }                                                                                   \
+    return NULL; }                                                                      \
+  static inline const char* name##_unpack(name##_t *v, const ts_pack_t *p) {            \
+    const char *estr; uint64_t tmp[TS_PACK_BLOCK], flip = name##__pack_flip();          \
+    if(v->m < p->n)                                                                     \
+      tsunlikely_if( (estr = name##_resize(v, p->n)) != NULL )                          \
+        return estr;                                                                    \
+    v->n = 0;                                                                           \
+    for(size_t b = 0 ; b < p->nblocks ; ++b) {                                          \
+      size_t k = ts_pack_decode_block(p, b, tmp);                                       \
+      for(size_t j = 0 ; j < k ; ++j) v->a[v->n++] = (type)(tmp[j] ^ flip);             \
+    }                                                                                   \
+    return NULL; }
+
+#endif
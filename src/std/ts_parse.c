@@ -0,0 +1,205 @@
+#include "libts.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TS_PARSE_SWAR 1
+#else
+#define TS_PARSE_SWAR 0
+#endif
+
+#define TS_PARSE_ISDIGIT(c) ((unsigned)(unsigned char)(c) - '0' < 10u)
+
+static const uint64_t ts_parse_pow10_u64[20] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+  100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+  10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+#if FLT_EVAL_METHOD == 0
+// exactly representable powers of ten
+static const double ts_parse_pow10_f64[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#endif
+
+#if TS_PARSE_SWAR
+// all 8 bytes in '0'..'9': high nibbles are 3, and adding 6 doesn't carry into them
+static inline int ts_parse_is8(uint64_t v) {
+  return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+// first byte is the most significant digit: combine pairs, then pairs of pairs, then halves
+static inline uint32_t ts_parse_8(uint64_t v) {
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 100 + (1000000ULL << 32);
+  const uint64_t mul2 = 1 + (10000ULL << 32);
+  v -= 0x3030303030303030ULL;
+  v  = (v * 10) + (v >> 8);
+  return (uint32_t)((((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32);
+}
+#endif
+
+// consumes all digits at p, *ovf is set when the value doesn't fit in 64 bits
+static inline const char * ts_parse_digits(const char *p, const char *end, uint64_t *ret,
+                                           int *ovf) {
+  const char *s = p;
+  uint64_t    x = 0;
+#if TS_PARSE_SWAR
+  uint64_t    v;
+  // two rounds at most, 16 digits can't overflow
+  while(end - p >= 8 && p - s <= 8) {
+    memcpy(&v, p, 8);
+    if(!ts_parse_is8(v)) break;
+    x  = x * 100000000 + ts_parse_8(v);
+    p += 8;
+  }
+#endif
+  for( ; p < end && TS_PARSE_ISDIGIT(*p) ; p++)
+    if(__builtin_mul_overflow(x, 10, &x) || __builtin_add_overflow(x, (uint64_t)(*p - '0'), &x))
+      *ovf = 1;
+  *ret = x;
+  return p;
+}
+
+size_t ts_parse_u64(const char *p, size_t n, uint64_t *ret) {
+  const char *s = p, *end = p + n, *q;
+  int         ovf = 0;
+  if(p < end && *p == '+') p++;
+  q = ts_parse_digits(p, end, ret, &ovf);
+  if(q == p || ovf) return 0;
+  return (size_t)(q - s);
+}
+
+size_t ts_parse_i64(const char *p, size_t n, int64_t *ret) {
+  const char *s = p, *end = p + n, *q;
+  int         ovf = 0, neg = 0;
+  uint64_t    x;
+  if(p < end && (*p == '+' || *p == '-')) neg = *p++ == '-';
+  q = ts_parse_digits(p, end, &x, &ovf);
+  if(q == p || ovf || x > (uint64_t) INT64_MAX + neg) return 0;
+  *ret = neg ? (int64_t)(0 - x) : (int64_t) x;
+  return (size_t)(q - s);
+}
+
+static inline int ts_parse_word(const char *p, const char *end, const char *w, size_t k) {
+  if((size_t)(end - p) < k) return 0;
+  for(size_t i = 0 ; i < k ; i++)
+    if((p[i] | 0x20) != w[i]) return 0;
+  return 1;
+}
+
+// created once, a thread losing the race frees its copy
+static locale_t ts_parse_c_locale(void) {
+  static locale_t cloc = (locale_t) 0;
+  locale_t        loc = __atomic_load_n(&cloc, __ATOMIC_ACQUIRE), expected = (locale_t) 0;
+  if(loc) return loc;
+  tsunlikely_if( (loc = newlocale(LC_NUMERIC_MASK, "C", (locale_t) 0)) == (locale_t) 0 )
+    return (locale_t) 0;
+  if(!__atomic_compare_exchange_n(&cloc, &expected, loc, 0, __ATOMIC_ACQ_REL,
+                                  __ATOMIC_ACQUIRE)) {
+    freelocale(loc);
+    loc = expected;
+  }
+  return loc;
+}
+
+static size_t ts_parse_f64_slow(const char *s, size_t k, double *ret) {
+  char      buf[128], *tmp = buf;
+  int       err = errno;
+  locale_t  loc;
+  tsunlikely_if( (loc = ts_parse_c_locale()) == (locale_t) 0 )
+    return 0;
+  if(k >= sizeof(buf))
+    tsunlikely_if( (tmp = (char *) malloc(k + 1)) == NULL )
+      return 0;
+  memcpy(tmp, s, k);
+  tmp[k] = '\0';
+  *ret = strtod_l(tmp, NULL, loc);
+  if(tmp != buf) free(tmp);
+  errno = err;
+  return k;
+}
+
+size_t ts_parse_f64(const char *p, size_t n, double *ret) {
+  const char *s = p, *end = p + n, *ip, *fp, *q;
+  int         neg = 0, ovf = 0, eneg = 0;
+  uint64_t    w, f = 0, ex = 0;
+  size_t      nint, nfrac = 0;
+  int64_t     e;
+
+  if(p < end && (*p == '+' || *p == '-')) neg = *p++ == '-';
+  if(p < end && !TS_PARSE_ISDIGIT(*p) && *p != '.') {
+    if(ts_parse_word(p, end, "nan", 3)) {
+      *ret = neg ? -__builtin_nan("") : __builtin_nan("");
+      return (size_t)(p + 3 - s);
+    }
+    if(ts_parse_word(p, end, "inf", 3)) {
+      *ret = neg ? -__builtin_inf() : __builtin_inf();
+      return (size_t)(p + (ts_parse_word(p, end, "infinity", 8) ? 8 : 3) - s);
+    }
+    return 0;
+  }
+
+  ip   = p;
+  p    = ts_parse_digits(p, end, &w, &ovf);
+  nint = (size_t)(p - ip);
+  if(p < end && *p == '.') {
+    fp    = ++p;
+    p     = ts_parse_digits(p, end, &f, &ovf);
+    nfrac = (size_t)(p - fp);
+  }
+  if(nint + nfrac == 0) return 0;
+
+  // the exponent only counts when it has digits, "1e" parses as 1
+  if(p < end && (*p | 0x20) == 'e') {
+    int eovf = 0;
+    q = p + 1;
+    if(q < end && (*q == '+' || *q == '-')) eneg = *q++ == '-';
+    fp = q;
+    q  = ts_parse_digits(q, end, &ex, &eovf);
+    if(q > fp) {
+      p  = q;
+      ex = eovf || ex > 100000 ? 100000 : ex;
+    } else {
+      ex = 0;
+    }
+  }
+
+  if(nint + nfrac <= 19) {
+    w = w * ts_parse_pow10_u64[nfrac] + f;
+    e = (eneg ? -(int64_t) ex : (int64_t) ex) - (int64_t) nfrac;
+    if(w == 0) {
+      *ret = neg ? -0.0 : 0.0;
+      return (size_t)(p - s);
+    }
+#if FLT_EVAL_METHOD == 0
+    // with excess precision (x87) the multiply / divide would round twice
+    if(w <= (1ULL << 53) && e >= -22 && e <= 22) {
+      double d = (double) w;
+      d    = e < 0 ? d / ts_parse_pow10_f64[-e] : d * ts_parse_pow10_f64[e];
+      *ret = neg ? -d : d;
+      return (size_t)(p - s);
+    }
+#else
+    (void) e;
+#endif
+  }
+  return ts_parse_f64_slow(s, (size_t)(p - s), ret);
+}
+
+#define TS_PARSE_BATCH(tname, type)                                                     \
+const char * ts_parse_##tname##_batch(type *out, const ts_strview_t *v, size_t n,       \
+                                      size_t *bad) {                                    \
+  for(size_t i = 0 ; i < n ; i++)                                                       \
+    tsunlikely_if(v[i].n == 0 || ts_parse_##tname(v[i].p, v[i].n, &out[i]) != v[i].n) { \
+      if(bad) *bad = i;                                                                 \
+      return "PARSE FAILED";                                                            \
+    }                                                                                   \
+  return NULL;                                                                          \
+}
+
+TS_PARSE_BATCH(u64, uint64_t)
+TS_PARSE_BATCH(i64, int64_t)
+TS_PARSE_BATCH(f64, double)
@@ -0,0 +1,35 @@
+#ifndef TS_PARSE_H__
+#define TS_PARSE_H__
+
+#include <float.h>
+#include <locale.h>
+
+/// number parsing on (ptr, len) without NUL, locale or errno.
+///   size_t k = ts_parse_i64(p, n, &x);    // k = bytes consumed, 0 = no number / out of range
+/// parsing stops at the first byte that can't continue the number, check k == n when the
+/// whole field must be a number. no leading whitespace is skipped.
+///
+/// integers: [+-]digits (no '-' for u64). 8 digits at a time with SWAR on little endian
+/// targets (one 64-bit load, validate and combine with 3 multiplies).
+/// floats: [+-]digits[.digits][(e|E)[+-]digits], inf, infinity, nan (any case).
+/// up to 19 significant digits with a decimal exponent in [-22, 22] and a mantissa below 2^53
+/// are converted exactly with one multiply / divide (Clinger's fast path), the rest goes to
+/// strtod_l in the "C" locale on a copy of the consumed bytes (errno is left untouched), so
+/// results are always correctly rounded. the fast path needs double arithmetic without
+/// excess precision (FLT_EVAL_METHOD == 0), x87 builds always take the slow path.
+///
+/// the _batch variants parse a column of views, each one must be a number as a whole,
+/// otherwise they return "PARSE FAILED" with the index of the bad view in *bad.
+
+TSC_EXTERN size_t ts_parse_u64(const char *p, size_t n, uint64_t *ret);
+TSC_EXTERN size_t ts_parse_i64(const char *p, size_t n, int64_t *ret);
+TSC_EXTERN size_t ts_parse_f64(const char *p, size_t n, double *ret);
+
+TSC_EXTERN const char * ts_parse_u64_batch(uint64_t *out, const ts_strview_t *v, size_t n,
+                                           size_t *bad);
+TSC_EXTERN const char * ts_parse_i64_batch(int64_t *out, const ts_strview_t *v, size_t n,
+                                           size_t *bad);
+TSC_EXTERN const char * ts_parse_f64_batch(double *out, const ts_strview_t *v, size_t n,
+                                           size_t *bad);
+
+#endif
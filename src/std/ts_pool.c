@@ -578,5 +578,26 @@ void * ts_pool_realloc(ts_pool_t *heap, void *ptr, size_t size ) {
   return( ptr );
 }
 
+static void * ts_pool_sds_malloc(void *ctx, size_t size) {
+  return ts_pool_malloc((ts_pool_t *) ctx, size);
+}
+
+static void * ts_pool_sds_realloc(void *ctx, void *ptr, size_t oldsize, size_t size) {
+  (void) oldsize;
+  return ts_pool_realloc((ts_pool_t *) ctx, ptr, size);
+}
+
+static void ts_pool_sds_free(void *ctx, void *ptr, size_t size) {
+  (void) size;
+  ts_pool_free((ts_pool_t *) ctx, ptr);
+}
+
+void ts_pool_sdsalloc(sdsallocator *sa, ts_pool_t *heap) {
+  sa->malloc  = ts_pool_sds_malloc;
+  sa->realloc = ts_pool_sds_realloc;
+  sa->free    = ts_pool_sds_free;
+  sa->ctx     = heap;
+}
+
 #endif
 
@@ -14,5 +14,8 @@ TSC_EXTERN void *       ts_pool_calloc(ts_pool_t *heap, size_t n, size_t size);
 TSC_EXTERN void *       ts_pool_realloc(ts_pool_t *heap, void *ptr, size_t size);
 TSC_EXTERN void *       ts_pool_info(ts_pool_t *heap, void *ptr);
 
+// fills *sa so sdsnewlen_a(sa, ...) places strings in the pool. sa must outlive them.
+TSC_EXTERN void         ts_pool_sdsalloc(sdsallocator *sa, ts_pool_t *heap);
+
 #endif
 #endif
@@ -0,0 +1,221 @@
+#ifndef TS_QUEUE_H__
+#define TS_QUEUE_H__
+
+#ifdef USE_TS_QUEUE
+
+/// bounded lock-free queues to hand items between threads, generated per type like ts_vec.
+///   ts_make_spsc_queue(name, type, cap)   one producer thread, one consumer thread
+///   ts_make_mpmc_queue(name, type, cap)   any number of both (Vyukov's sequence slots)
+/// cap must be a power of two. push / pop never block, they return 0 when full / empty.
+/// push_n / pop_n move up to n items with a single update of the shared index.
+/// (opt-in with USE_TS_QUEUE like ts_chmap)
+
+// blocking:
+// init(q, 1) turns on push_wait / pop_wait. a waiting thread sleeps on a futex (sched_yield
+// outside linux) and every push / pop checks for sleepers behind a fence. that check is the
+// only cost of blocking mode, with init(q, 0) the fast paths do no extra work, but then
+// push_wait / pop_wait must not be used (nobody would wake them up).
+//
+// producer and consumer indices sit on their own cache lines. the spsc queue also keeps a
+// private copy of the other side's index, so the shared line is only read when the cached
+// view says full / empty.
+
+#ifdef __linux__
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+#else
+  #include <sched.h>
+#endif
+
+#define TS_QUEUE_CACHELINE 64
+#define TS_QUEUE_ALIGNED   __attribute__((aligned(TS_QUEUE_CACHELINE)))
+
+typedef struct { uint32_t seq; uint32_t waiters; } ts_queue_event_t;
+
+static inline void ts_queue_futex_wait(uint32_t *addr, uint32_t val) {
+#ifdef __linux__
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+  if(__atomic_load_n(addr, __ATOMIC_ACQUIRE) == val) sched_yield();
+#endif
+}
+
+static inline void ts_queue_futex_wake(uint32_t *addr) {
+#ifdef __linux__
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+  (void)addr;
+#endif
+}
+
+// announce a waiter, the caller must re-check the queue before ts_queue_event_wait
+static inline uint32_t ts_queue_event_prepare(ts_queue_event_t *ev) {
+  __atomic_fetch_add(&ev->waiters, 1, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return __atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE);
+}
+
+static inline void ts_queue_event_wait(ts_queue_event_t *ev, uint32_t seq) {
+  ts_queue_futex_wait(&ev->seq, seq);
+}
+
+static inline void ts_queue_event_done(ts_queue_event_t *ev) {
+  __atomic_fetch_sub(&ev->waiters, 1, __ATOMIC_RELAXED);
+}
+
+// pairs with the fence in prepare: either the waiter sees the new item, or we see the waiter
+static inline void ts_queue_event_notify(ts_queue_event_t *ev) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&ev->waiters, __ATOMIC_RELAXED) == 0) return;
+  __atomic_fetch_add(&ev->seq, 1, __ATOMIC_SEQ_CST);
+  ts_queue_futex_wake(&ev->seq);
+}
+
+// waits until expr (a push / pop attempt) succeeds
+#define ts_queue_wait_until(ev, expr) do {                                              \
+    uint32_t seq__;                                                                     \
+    if(expr) break;                                                                     \
+    for(;;) {                                                                           \
+      seq__ = ts_queue_event_prepare(ev);                                               \
+      if(expr) { ts_queue_event_done(ev); break; }                                      \
+      ts_queue_event_wait(ev, seq__);                                                   \
+      ts_queue_event_done(ev);                                                          \
+    }                                                                                   \
+  } while(0)
+
+#define ts_make_spsc_queue(name, type, cap)                                             \
+  typedef struct {                                                                      \
+    type *a; int blocking;                                                              \
+    size_t head TS_QUEUE_ALIGNED; size_t tail_cache;      /* consumer */                \
+    size_t tail TS_QUEUE_ALIGNED; size_t head_cache;      /* producer */                \
+    ts_queue_event_t not_empty TS_QUEUE_ALIGNED;                                        \
+    ts_queue_event_t not_full  TS_QUEUE_ALIGNED;                                        \
+  } name##_t;                                                                           \
+  static inline const char* name##_init(name##_t *q, int blocking) {                    \
+    memset(q, 0, sizeof(*q)); q->blocking = blocking;                                   \
+    tsunlikely_if( (q->a = (type*)malloc(sizeof(type) * (cap))) == NULL )               \
+      return "OOM";                                                                     \
+    return NULL; }                                                                      \
+  static inline void name##_destroy(name##_t *q) { free(q->a); q->a = 0; }              \
+  static inline size_t name##_size(name##_t *q) {                                       \
+    return __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE)                                  \
+         - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE); }                               \
+  static inline size_t name##_push_n(name##_t *q, const type *src, size_t n) {          \
+    size_t t = q->tail, k, i, first;                                                    \
+    if((cap) - (t - q->head_cache) < n)                                                 \
+      q->head_cache = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);                      \
+    k = (cap) - (t - q->head_cache);                                                    \
+    if(k > n) k = n;                                                                    \
+    if(k == 0) return 0;                                                                \
+    i = t & ((cap) - 1); first = (cap) - i < k ? (cap) - i : k;                         \
+    memcpy(q->a + i, src, sizeof(type) * first);                                        \
+    memcpy(q->a, src + first, sizeof(type) * (k - first));                              \
+    __atomic_store_n(&q->tail, t + k, __ATOMIC_RELEASE);                                \
+    if(q->blocking) ts_queue_event_notify(&q->not_empty);                               \
+    return k; }                                                                         \
+  static inline size_t name##_pop_n(name##_t *q, type *dst, size_t n) {                 \
+    size_t h = q->head, k, i, first;                                                    \
+    if(q->tail_cache - h < n)                                                           \
+      q->tail_cache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);                      \
+    k = q->tail_cache - h;                                                              \
+    if(k > n) k = n;                                                                    \
+    if(k == 0) return 0;                                                                \
+    i = h & ((cap) - 1); first = (cap) - i < k ? (cap) - i : k;                         \
+    memcpy(dst, q->a + i, sizeof(type) * first);                                        \
+    memcpy(dst + first, q->a, sizeof(type) * (k - first));                              \
+    __atomic_store_n(&q->head, h + k, __ATOMIC_RELEASE);                                \
+    if(q->blocking) ts_queue_event_notify(&q->not_full);                                \
+    return k; }                                                                         \
+  static inline int name##_push(name##_t *q, type x) {                                  \
+    size_t t = q->tail;                                                                 \
+    if(t - q->head_cache == (cap)) {                                                    \
+      q->head_cache = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);                      \
+      if(t - q->head_cache == (cap)) return 0;                                          \
+    }                                                                                   \
+    q->a[t & ((cap) - 1)] = x;                                                          \
+    __atomic_store_n(&q->tail, t + 1, __ATOMIC_RELEASE);                                \
+    if(q->blocking) ts_queue_event_notify(&q->not_empty);                               \
+    return 1; }                                                                         \
+  static inline int name##_pop(name##_t *q, type *out) {                                \
+    size_t h = q->head;                                                                 \
+    if(h == q->tail_cache) {                                                            \
+      q->tail_cache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);                      \
+      if(h == q->tail_cache) return 0;                                                  \
+    }                                                                                   \
+    *out = q->a[h & ((cap) - 1)];                                                       \
+    __atomic_store_n(&q->head, h + 1, __ATOMIC_RELEASE);                                \
+    if(q->blocking) ts_queue_event_notify(&q->not_full);                                \
+    return 1; }                                                                         \
+  static inline void name##_push_wait(name##_t *q, type x) {                            \
+    ts_queue_wait_until(&q->not_full, name##_push(q, x)); }                             \
+  static inline type name##_pop_wait(name##_t *q) {                                     \
+    type x; ts_queue_wait_until(&q->not_empty, name##_pop(q, &x)); return x; }
+
+#define ts_make_mpmc_queue(name, type, cap)                                             \
+  typedef struct { size_t seq; type val; } name##_cell_t;                               \
+  typedef struct {                                                                      \
+    name##_cell_t *cells; int blocking;                                                 \
+    size_t enq TS_QUEUE_ALIGNED;                                                        \
+    size_t deq TS_QUEUE_ALIGNED;                                                        \
+    ts_queue_event_t not_empty TS_QUEUE_ALIGNED;                                        \
+    ts_queue_event_t not_full  TS_QUEUE_ALIGNED;                                        \
+  } name##_t;                                                                           \
+  static inline const char* name##_init(name##_t *q, int blocking) {                    \
+    memset(q, 0, sizeof(*q)); q->blocking = blocking;                                   \
+    q->cells = (name##_cell_t*)malloc(sizeof(name##_cell_t) * (cap));                   \
+    tsunlikely_if(q->cells == NULL) return "OOM";                                       \
+    for(size_t i = 0 ; i < (cap) ; ++i) q->cells[i].seq = i;                            \
+    return NULL; }                                                                      \
+  static inline void name##_destroy(name##_t *q) { free(q->cells); q->cells = 0; }      \
+  static inline size_t name##_size(name##_t *q) {                                       \
+    size_t e = __atomic_load_n(&q->enq, __ATOMIC_ACQUIRE);                              \
+    size_t d = __atomic_load_n(&q->deq, __ATOMIC_ACQUIRE);                              \
+    return e > d ? e - d : 0; }                                                         \
+  /* claims up to n consecutive tickets on ctr, cell seq must equal ticket + off */     \
+  static inline size_t name##__claim(name##_t *q, size_t *ctr, size_t off, size_t n,    \
+    size_t *pos) {                                                                      \
+    size_t p = __atomic_load_n(ctr, __ATOMIC_RELAXED), k, seq;                          \
+    for(;;) {                                                                           \
+      for(k = 0 ; k < n ; ++k) {                                                        \
+        seq = __atomic_load_n(&q->cells[(p + k) & ((cap) - 1)].seq, __ATOMIC_ACQUIRE);  \
+        if(seq != p + k + off) break;                                                   \
+      }                                                                                 \
+      if(k == 0) {                                                                      \
+        seq = __atomic_load_n(&q->cells[p & ((cap) - 1)].seq, __ATOMIC_ACQUIRE);        \
+        if((intptr_t)(seq - (p + off)) < 0) return 0;    /* full / empty */             \
+        p = __atomic_load_n(ctr, __ATOMIC_RELAXED);      /* someone else got it */      \
+        continue;                                                                       \
+      }                                                                                 \
+      if(__atomic_compare_exchange_n(ctr, &p, p + k, 1,                                 \
+           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;                                  \
+    }                                                                                   \
+    *pos = p; return k; }                                                               \
+  static inline size_t name##_push_n(name##_t *q, const type *src, size_t n) {          \
+    size_t p, k = n ? name##__claim(q, &q->enq, 0, n, &p) : 0;                          \
+    for(size_t i = 0 ; i < k ; ++i) {                                                   \
+      name##_cell_t *c = &q->cells[(p + i) & ((cap) - 1)];                              \
+      c->val = src[i];                                                                  \
+      __atomic_store_n(&c->seq, p + i + 1, __ATOMIC_RELEASE);                           \
+    }                                                                                   \
+    if(k && q->blocking) ts_queue_event_notify(&q->not_empty);                          \
+    return k; }                                                                         \
+  static inline size_t name##_pop_n(name##_t *q, type *dst, size_t n) {                 \
+    size_t p, k = n ? name##__claim(q, &q->deq, 1, n, &p) : 0;                          \
+    for(size_t i = 0 ; i < k ; ++i) {                                                   \
+      name##_cell_t *c = &q->cells[(p + i) & ((cap) - 1)];                              \
+      dst[i] = c->val;                                                                  \
+      __atomic_store_n(&c->seq, p + i + (cap), __ATOMIC_RELEASE);                       \
+    }                                                                                   \
+    if(k && q->blocking) ts_queue_event_notify(&q->not_full);                           \
+    return k; }                                                                         \
+  static inline int name##_push(name##_t *q, type x) {                                  \
+    return (int) name##_push_n(q, &x, 1); }                                             \
+  static inline int name##_pop(name##_t *q, type *out) {                                \
+    return (int) name##_pop_n(q, out, 1); }                                             \
+  static inline void name##_push_wait(name##_t *q, type x) {                            \
+    ts_queue_wait_until(&q->not_full, name##_push(q, x)); }                             \
+  static inline type name##_pop_wait(name##_t *q) {                                     \
+    type x; ts_queue_wait_until(&q->not_empty, name##_pop(q, &x)); return x; }
+
+#endif
+#endif
@@ -0,0 +1,216 @@
+#include "libts.h"
+
+void ts_rope_init(ts_rope_t *r) {
+  memset(r, 0, sizeof(*r));
+}
+
+static void ts_rope_release(ts_rope_t *r) {
+  for(size_t i = 0 ; i < r->nblocks ; i++)
+    if(--r->blocks[i]->refs == 0) free(r->blocks[i]);
+  r->nblocks = 0;
+  r->cur = r->end = NULL;
+}
+
+void ts_rope_destroy(ts_rope_t *r) {
+  ts_rope_release(r);
+  free(r->blocks);
+  free(r->iov);
+  memset(r, 0, sizeof(*r));
+}
+
+void ts_rope_clear(ts_rope_t *r) {
+  ts_rope_release(r);
+  r->head = r->m / 2;
+  r->n    = 0;
+  r->len  = 0;
+}
+
+// makes room for one piece at the front / back. the array doubles when more than half
+// full, otherwise the pieces are just moved, leaving most of the free room where needed.
+static const char * ts_rope_room(ts_rope_t *r, int front) {
+  size_t        m = r->m, head;
+  struct iovec *a = r->iov;
+  if(front ? r->head > 0 : r->head + r->n < r->m) return NULL;
+  if(r->m == 0 || r->n * 2 > r->m) {
+    m = r->m ? r->m * 2 : 16;
+    tsunlikely_if( (a = (struct iovec *) realloc(r->iov, m * sizeof(struct iovec))) == NULL )
+      return "OOM";
+  }
+  head = front ? m - r->n - (m - r->n) / 4 : (m - r->n) / 4;
+  memmove(a + head, a + r->head, r->n * sizeof(struct iovec));
+  r->iov  = a;
+  r->m    = m;
+  r->head = head;
+  return NULL;
+}
+
+const char * ts_rope_append(ts_rope_t *r, const void *p, size_t n) {
+  const char *estr;
+  if(n == 0) return NULL;
+  tsunlikely_if( (estr = ts_rope_room(r, 0)) != NULL )
+    return estr;
+  r->iov[r->head + r->n].iov_base = (void *) p;
+  r->iov[r->head + r->n].iov_len  = n;
+  r->n++;
+  r->len += n;
+  return NULL;
+}
+
+const char * ts_rope_prepend(ts_rope_t *r, const void *p, size_t n) {
+  const char *estr;
+  if(n == 0) return NULL;
+  tsunlikely_if( (estr = ts_rope_room(r, 1)) != NULL )
+    return estr;
+  r->head--;
+  r->iov[r->head].iov_base = (void *) p;
+  r->iov[r->head].iov_len  = n;
+  r->n++;
+  r->len += n;
+  return NULL;
+}
+
+static const char * ts_rope_add_block(ts_rope_t *r, ts_rope_block_t *b) {
+  if(r->nblocks == r->mblocks) {
+    size_t            m = r->mblocks ? r->mblocks * 2 : 8;
+    ts_rope_block_t **a = (ts_rope_block_t **) realloc(r->blocks, m * sizeof(*a));
+    tsunlikely_if(a == NULL) return "OOM";
+    r->blocks  = a;
+    r->mblocks = m;
+  }
+  r->blocks[r->nblocks++] = b;
+  return NULL;
+}
+
+// copies p into rope owned memory, *ret points to the copy
+static const char * ts_rope_copy(ts_rope_t *r, const void *p, size_t n, char **ret) {
+  const char      *estr;
+  ts_rope_block_t *b;
+  int              own = n > TS_ROPE_BLOCK / 4;
+
+  if(own || (size_t)(r->end - r->cur) < n) {
+    size_t cap = own ? n : TS_ROPE_BLOCK;
+    tsunlikely_if( (b = (ts_rope_block_t *) malloc(sizeof(*b) + cap)) == NULL )
+      return "OOM";
+    b->refs = 1;
+    tsunlikely_if( (estr = ts_rope_add_block(r, b)) != NULL ) {
+      free(b);
+      return estr;
+    }
+    if(own) {
+      *ret = b->data;
+      memcpy(*ret, p, n);
+      return NULL;
+    }
+    r->cur = b->data;
+    r->end = b->data + cap;
+  }
+  *ret = r->cur;
+  r->cur += n;
+  memcpy(*ret, p, n);
+  return NULL;
+}
+
+const char * ts_rope_append_copy(ts_rope_t *r, const void *p, size_t n) {
+  const char *estr;
+  char       *c;
+  if(n == 0) return NULL;
+  tsunlikely_if( (estr = ts_rope_copy(r, p, n, &c)) != NULL )
+    return estr;
+  return ts_rope_append(r, c, n);
+}
+
+const char * ts_rope_prepend_copy(ts_rope_t *r, const void *p, size_t n) {
+  const char *estr;
+  char       *c;
+  if(n == 0) return NULL;
+  tsunlikely_if( (estr = ts_rope_copy(r, p, n, &c)) != NULL )
+    return estr;
+  return ts_rope_prepend(r, c, n);
+}
+
+const char * ts_rope_split(ts_rope_t *r, size_t off, ts_rope_t *out) {
+  const char   *estr;
+  struct iovec *v = r->iov + r->head;
+  size_t        i = 0, pos = 0, cut;
+
+  tsunlikely_if(off > r->len) return "OFFSET OUT OF RANGE";
+  while(i < r->n && pos + v[i].iov_len <= off) pos += v[i++].iov_len;
+  ts_rope_init(out);
+  // out shares (and references) every block, the open one included. out->cur / end stay
+  // NULL, so only r ever writes into the open block and out starts its own on first copy
+  for(size_t b = 0 ; b < r->nblocks ; b++) {
+    tsunlikely_if( (estr = ts_rope_add_block(out, r->blocks[b])) != NULL ) {
+      ts_rope_destroy(out);
+      return estr;
+    }
+    r->blocks[b]->refs++;
+  }
+  if(i == r->n) return NULL;
+  cut = off - pos;
+  tsunlikely_if( (estr = ts_rope_append(out, (char *) v[i].iov_base + cut,
+                                        v[i].iov_len - cut)) != NULL ) {
+    ts_rope_destroy(out);
+    return estr;
+  }
+  for(size_t j = i + 1 ; j < r->n ; j++)
+    tsunlikely_if( (estr = ts_rope_append(out, v[j].iov_base, v[j].iov_len)) != NULL ) {
+      ts_rope_destroy(out);
+      return estr;
+    }
+  v[i].iov_len = cut;
+  r->n   = cut ? i + 1 : i;
+  r->len = off;
+  return NULL;
+}
+
+static void ts_rope_copy_out(char *dst, const ts_rope_t *r) {
+  const struct iovec *v = ts_rope_iov(r);
+  for(size_t i = 0 ; i < r->n ; i++) {
+    memcpy(dst, v[i].iov_base, v[i].iov_len);
+    dst += v[i].iov_len;
+  }
+}
+
+const char * ts_rope_flatten(char **ret, const ts_rope_t *r) {
+  tsunlikely_if( (*ret = (char *) malloc(r->len + 1)) == NULL )
+    return "OOM";
+  ts_rope_copy_out(*ret, r);
+  (*ret)[r->len] = '\0';
+  return NULL;
+}
+
+sds ts_rope_catsds(sds s, const ts_rope_t *r) {
+  tsunlikely_if( (s = sdsMakeRoomFor(s, r->len)) == NULL )
+    return NULL;
+  ts_rope_copy_out(s + sdslen(s), r);
+  sdssetlen(s, sdslen(s) + r->len);
+  s[sdslen(s)] = '\0';
+  return s;
+}
+
+// writev takes at most IOV_MAX pieces per call and may write less than asked
+const char * ts_rope_write(const ts_rope_t *r, int fd) {
+  const struct iovec *v = ts_rope_iov(r);
+  struct iovec        part;
+  size_t              i = 0, done = 0;
+  ssize_t             w;
+
+  while(i < r->n) {
+    int cnt = r->n - i < IOV_MAX ? (int)(r->n - i) : IOV_MAX;
+    if(done) {
+      // finish a partially written piece first
+      part.iov_base = (char *) v[i].iov_base + done;
+      part.iov_len  = v[i].iov_len - done;
+      w = writev(fd, &part, 1);
+    } else {
+      w = writev(fd, v + i, cnt);
+    }
+    if(w < 0) {
+      if(errno == EINTR) continue;
+      return strerror(errno);
+    }
+    done += (size_t) w;
+    while(i < r->n && done >= v[i].iov_len) done -= v[i++].iov_len;
+  }
+  return NULL;
+}
@@ -0,0 +1,58 @@
+#ifndef TS_ROPE_H__
+#define TS_ROPE_H__
+
+#include <sys/uio.h>
+
+/// ts_rope_t assembles a large output from pieces without copying them: a piece is a
+/// (pointer, length) reference kept as a struct iovec, so the pieces can go straight to
+/// writev and the bytes are copied once at most, by ts_rope_flatten / ts_rope_catsds.
+///
+///   ts_rope_t r;
+///   ts_rope_init(&r);
+///   ts_rope_append(&r, body, body_len);        // reference, body must outlive r
+///   ts_rope_prepend_copy(&r, hdr, hdr_len);     // copied into the rope
+///   ts_rope_write(&r, fd);
+///   ts_rope_destroy(&r);
+///
+/// append / prepend are O(1) amortized: the iovec array keeps free room at both ends.
+/// ts_rope_split moves the bytes after an offset into another rope, O(pieces).
+
+// the _copy variants store the bytes in TS_ROPE_BLOCK byte blocks owned by the rope
+// (larger copies get a block of their own). blocks are reference counted, a rope made by
+// ts_rope_split shares them, so either rope can be destroyed first.
+
+#define TS_ROPE_BLOCK 4096
+
+typedef struct ts_rope_block {
+  size_t refs;
+  char   data[];
+} ts_rope_block_t;
+
+typedef struct {
+  struct iovec     *iov;          // pieces are iov[head, head + n)
+  size_t            head, n, m;
+  size_t            len;          // total bytes
+  ts_rope_block_t **blocks;
+  size_t            nblocks, mblocks;
+  char             *cur, *end;    // free space in the newest block
+} ts_rope_t;
+
+TSC_EXTERN void         ts_rope_init(ts_rope_t *r);
+TSC_EXTERN void         ts_rope_destroy(ts_rope_t *r);
+TSC_EXTERN void         ts_rope_clear(ts_rope_t *r);
+TSC_EXTERN const char * ts_rope_append(ts_rope_t *r, const void *p, size_t n);
+TSC_EXTERN const char * ts_rope_prepend(ts_rope_t *r, const void *p, size_t n);
+TSC_EXTERN const char * ts_rope_append_copy(ts_rope_t *r, const void *p, size_t n);
+TSC_EXTERN const char * ts_rope_prepend_copy(ts_rope_t *r, const void *p, size_t n);
+TSC_EXTERN const char * ts_rope_split(ts_rope_t *r, size_t off, ts_rope_t *out);
+TSC_EXTERN const char * ts_rope_flatten(char **ret, const ts_rope_t *r);
+TSC_EXTERN sds          ts_rope_catsds(sds s, const ts_rope_t *r);
+TSC_EXTERN const char * ts_rope_write(const ts_rope_t *r, int fd);
+
+static inline size_t ts_rope_len(const ts_rope_t *r) { return r->len; }
+static inline size_t ts_rope_count(const ts_rope_t *r) { return r->n; }
+
+// the pieces in order, ts_rope_count of them
+static inline const struct iovec * ts_rope_iov(const ts_rope_t *r) { return r->iov + r->head; }
+
+#endif
@@ -0,0 +1,225 @@
+#include "libts.h"
+
+#define TS_SEARCH_LOWER(c) ((unsigned)(unsigned char)(c) - 'A' < 26u ? (c) | 0x20 : (c))
+#define TS_SEARCH_ISALPHA(c) (((unsigned)(unsigned char)(c) | 0x20) - 'a' < 26u)
+
+static inline int ts_search_eq_nocase(const char *a, const char *b, size_t n) {
+  for(size_t i = 0 ; i < n ; i++)
+    if(TS_SEARCH_LOWER(a[i]) != TS_SEARCH_LOWER(b[i])) return 0;
+  return 1;
+}
+
+// fold is 0x20 when the needle byte is a letter: (byte | 0x20) == (c | 0x20) then matches both
+// cases of that letter and nothing else. fold 0 is an exact compare.
+#define TS_SEARCH_BODY(EQ)                                                              \
+  const char first = needle[0], last = needle[m - 1];                                   \
+  const char ff = nocase && TS_SEARCH_ISALPHA(first) ? 0x20 : 0;                        \
+  const char fl = nocase && TS_SEARCH_ISALPHA(last)  ? 0x20 : 0;                        \
+  const size_t mid = m > 1 ? m - 2 : 0;                                                 \
+  size_t i = 0;                                                                         \
+  TS_SEARCH_SIMD(EQ)                                                                    \
+  for( ; i + m <= n ; i++)                                                              \
+    if((hay[i] | ff) == (first | ff) && (hay[i + m - 1] | fl) == (last | fl) &&         \
+       EQ(hay + i + 1, needle + 1, mid))                                                \
+      return hay + i;                                                                   \
+  return NULL;
+
+#if defined(__AVX2__)
+#define TS_SEARCH_SIMD(EQ)                                                              \
+  {                                                                                     \
+    const __m256i F = _mm256_set1_epi8(first | ff), FF = _mm256_set1_epi8(ff);          \
+    const __m256i L = _mm256_set1_epi8(last | fl),  FL = _mm256_set1_epi8(fl);          \
+    for( ; i + m - 1 + 32 <= n ; i += 32) {                                             \
+      __m256i  a = _mm256_loadu_si256((const __m256i *)(hay + i));                      \
+      __m256i  b = _mm256_loadu_si256((const __m256i *)(hay + i + m - 1));              \
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(                 \
+        _mm256_cmpeq_epi8(_mm256_or_si256(a, FF), F),                                   \
+        _mm256_cmpeq_epi8(_mm256_or_si256(b, FL), L)));                                 \
+      for( ; mask ; mask &= mask - 1) {                                                 \
+        size_t j = i + (size_t) __builtin_ctz(mask);                                    \
+        if(EQ(hay + j + 1, needle + 1, mid)) return hay + j;                            \
+      }                                                                                 \
+    }                                                                                   \
+  }
+#elif defined(__SSE2__)
+#define TS_SEARCH_SIMD(EQ)                                                              \
+  {                                                                                     \
+    const __m128i F = _mm_set1_epi8(first | ff), FF = _mm_set1_epi8(ff);                \
+    const __m128i L = _mm_set1_epi8(last | fl),  FL = _mm_set1_epi8(fl);                \
+    for( ; i + m - 1 + 16 <= n ; i += 16) {                                             \
+      __m128i  a = _mm_loadu_si128((const __m128i *)(hay + i));                         \
+      __m128i  b = _mm_loadu_si128((const __m128i *)(hay + i + m - 1));                 \
+      uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(                       \
+        _mm_cmpeq_epi8(_mm_or_si128(a, FF), F),                                         \
+        _mm_cmpeq_epi8(_mm_or_si128(b, FL), L)));                                       \
+      for( ; mask ; mask &= mask - 1) {                                                 \
+        size_t j = i + (size_t) __builtin_ctz(mask);                                    \
+        if(EQ(hay + j + 1, needle + 1, mid)) return hay + j;                            \
+      }                                                                                 \
+    }                                                                                   \
+  }
+#else
+#define TS_SEARCH_SIMD(EQ)
+#endif
+
+#define TS_SEARCH_EQ(a, b, n) (memcmp((a), (b), (n)) == 0)
+
+const char * ts_search(const char *hay, size_t n, const char *needle, size_t m) {
+  const int nocase = 0;
+  if(m == 0) return hay;
+  if(m > n)  return NULL;
+  if(m == 1) return (const char *) memchr(hay, needle[0], n);
+  TS_SEARCH_BODY(TS_SEARCH_EQ)
+}
+
+const char * ts_search_nocase(const char *hay, size_t n, const char *needle, size_t m) {
+  const int nocase = 1;
+  if(m == 0) return hay;
+  if(m > n)  return NULL;
+  TS_SEARCH_BODY(ts_search_eq_nocase)
+}
+
+const char * ts_ac_init(ts_ac_t *ac, int nocase) {
+  memset(ac, 0, sizeof(*ac));
+  ac->nocase = nocase;
+  tsunlikely_if( (ac->pbuf = sdsempty()) == NULL )
+    return "OOM";
+  return NULL;
+}
+
+static void ts_ac_free_automaton(ts_ac_t *ac) {
+  free(ac->delta);
+  free(ac->term);
+  free(ac->dict);
+  ac->delta   = NULL;
+  ac->term    = NULL;
+  ac->dict    = NULL;
+  ac->nstates = 0;
+}
+
+void ts_ac_destroy(ts_ac_t *ac) {
+  ts_ac_free_automaton(ac);
+  free(ac->plen);
+  free(ac->poff);
+  free(ac->pnext);
+  sdsfree(ac->pbuf);
+  memset(ac, 0, sizeof(*ac));
+}
+
+const char * ts_ac_add(ts_ac_t *ac, const char *pattern, size_t len) {
+  sds tmp;
+  tsunlikely_if(len == 0) return "EMPTY PATTERN";
+  if(ac->npat == ac->mpat) {
+    size_t  m = ac->mpat ? ac->mpat << 1 : 16;
+    size_t  *l, *o;
+    int32_t *nx;
+    tsunlikely_if( (l = (size_t *) realloc(ac->plen, m * sizeof(size_t))) == NULL )
+      return "OOM";
+    ac->plen = l;
+    tsunlikely_if( (o = (size_t *) realloc(ac->poff, m * sizeof(size_t))) == NULL )
+      return "OOM";
+    ac->poff = o;
+    tsunlikely_if( (nx = (int32_t *) realloc(ac->pnext, m * sizeof(int32_t))) == NULL )
+      return "OOM";
+    ac->pnext = nx;
+    ac->mpat  = m;
+  }
+  tsunlikely_if( (tmp = sdscatlen(ac->pbuf, pattern, len)) == NULL )
+    return "OOM";
+  ac->pbuf = tmp;
+  ac->plen[ac->npat] = len;
+  ac->poff[ac->npat] = sdslen(ac->pbuf) - len;
+  ac->npat++;
+  return NULL;
+}
+
+const char * ts_ac_build(ts_ac_t *ac) {
+  size_t    total = sdslen(ac->pbuf), nc, qh = 0, qt = 0;
+  uint32_t *fail = NULL, *queue = NULL, s, t, f;
+
+  ts_ac_free_automaton(ac);
+  tsunlikely_if(ac->npat == 0) return "NO PATTERNS";
+
+  // byte classes, both cases of a letter share one class when nocase
+  memset(ac->cls, 0, sizeof(ac->cls));
+  nc = 1;
+  for(size_t i = 0 ; i < total ; i++) {
+    uint8_t b = (uint8_t)(ac->nocase ? TS_SEARCH_LOWER(ac->pbuf[i]) : ac->pbuf[i]);
+    if(ac->cls[b] == 0) ac->cls[b] = (uint16_t) nc++;
+  }
+  if(ac->nocase)
+    for(int c = 'A' ; c <= 'Z' ; c++)
+      ac->cls[c] = ac->cls[c | 0x20];
+  ac->nclasses = (uint32_t) nc;
+
+  // trie, at most total + 1 states
+  tsunlikely_if(total + 1 > UINT32_MAX / nc) return "TOO MANY PATTERNS";
+  ac->delta = (uint32_t *) calloc((total + 1) * nc, sizeof(uint32_t));
+  ac->term  = (int32_t *)  malloc((total + 1) * sizeof(int32_t));
+  ac->dict  = (uint32_t *) calloc(total + 1, sizeof(uint32_t));
+  fail      = (uint32_t *) calloc(total + 1, sizeof(uint32_t));
+  queue     = (uint32_t *) malloc((total + 1) * sizeof(uint32_t));
+  tsunlikely_if(!ac->delta || !ac->term || !ac->dict || !fail || !queue) {
+    free(fail);
+    free(queue);
+    ts_ac_free_automaton(ac);
+    return "OOM";
+  }
+  ac->term[0] = -1;
+  ac->nstates = 1;
+  for(size_t p = 0 ; p < ac->npat ; p++) {
+    s = 0;
+    for(size_t i = 0 ; i < ac->plen[p] ; i++) {
+      uint32_t *e = &ac->delta[s * nc + ac->cls[(uint8_t) ac->pbuf[ac->poff[p] + i]]];
+      if(*e == 0) {
+        ac->term[ac->nstates] = -1;
+        *e = ac->nstates++;
+      }
+      s = *e;
+    }
+    ac->pnext[p] = ac->term[s];
+    ac->term[s]  = (int32_t) p;
+  }
+
+  // breadth first: failure links, dictionary links, and missing edges filled in from the
+  // failure state (whose row is already complete, it is shallower)
+  queue[qt++] = 0;
+  while(qh < qt) {
+    s = queue[qh++];
+    for(size_t c = 0 ; c < nc ; c++) {
+      t = ac->delta[s * nc + c];
+      if(t) {
+        f = s ? ac->delta[fail[s] * nc + c] : 0;
+        fail[t]     = f;
+        ac->dict[t] = ac->term[f] >= 0 ? f : ac->dict[f];
+        queue[qt++] = t;
+      } else if(s) {
+        ac->delta[s * nc + c] = ac->delta[fail[s] * nc + c];
+      }
+    }
+  }
+
+  free(fail);
+  free(queue);
+  return NULL;
+}
+
+size_t ts_ac_scan(const ts_ac_t *ac, const char *text, size_t n, ts_ac_match_fn on_match,
+                  void *ud) {
+  const uint32_t *delta = ac->delta;
+  const uint32_t  nc    = ac->nclasses;
+  size_t          count = 0;
+  uint32_t        s = 0, x;
+
+  if(ac->delta == NULL) return 0;
+  for(size_t i = 0 ; i < n ; i++) {
+    s = delta[s * nc + ac->cls[(uint8_t) text[i]]];
+    if(tslikely(ac->term[s] < 0 && ac->dict[s] == 0)) continue;
+    for(x = ac->term[s] >= 0 ? s : ac->dict[s] ; x ; x = ac->dict[x])
+      for(int32_t p = ac->term[x] ; p >= 0 ; p = ac->pnext[p]) {
+        count++;
+        if(on_match && on_match(ud, (size_t) p, i + 1)) return count;
+      }
+  }
+  return count;
+}
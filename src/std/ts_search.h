@@ -0,0 +1,57 @@
+#ifndef TS_SEARCH_H__
+#define TS_SEARCH_H__
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// substring search.
+///   ts_search(hay, n, needle, m)          memmem, NULL when not found
+///   ts_search_nocase(hay, n, needle, m)   same, ASCII letters compare case insensitive
+/// candidates are filtered 16 / 32 positions at a time (SSE2 / AVX2) by comparing the first
+/// and the last byte of the needle, only positions where both match get a memcmp.
+///
+/// ts_ac_t finds many literal patterns in one pass over the text (Aho-Corasick).
+///   ts_ac_init(&ac, nocase);
+///   ts_ac_add(&ac, "error", 5);        // pattern ids are 0, 1, 2 ... in add order
+///   ts_ac_build(&ac);
+///   ts_ac_scan(&ac, text, len, on_match, ud);
+/// the automaton is a full transition table over byte classes (only the bytes that appear
+/// in some pattern get their own class), so a scan step is one table load per byte.
+/// after ts_ac_build the automaton is read only, several threads can scan with it.
+
+// on_match(ud, pattern id, end offset) is called for every occurrence (overlapping ones too),
+// the match starts at end - pattern length. return non zero from it to stop the scan.
+// ts_ac_scan returns the number of matches reported, on_match == NULL just counts.
+
+typedef int (*ts_ac_match_fn)(void *ud, size_t pat, size_t end);
+
+typedef struct {
+  int       nocase;
+  uint16_t  cls[256];   // byte -> class, class 0 is "not in any pattern"
+  uint32_t  nclasses;
+  uint32_t  nstates;
+  uint32_t *delta;      // nstates x nclasses transitions
+  int32_t  *term;       // first pattern ending at the state, -1 if none
+  uint32_t *dict;       // closest state on the failure chain with a term, 0 if none
+  size_t    npat, mpat;
+  size_t   *plen;
+  size_t   *poff;       // offset of the pattern bytes in pbuf
+  int32_t  *pnext;      // next pattern with the same terminal state
+  sds       pbuf;
+} ts_ac_t;
+
+TSC_EXTERN const char * ts_search(const char *hay, size_t n, const char *needle, size_t m);
+TSC_EXTERN const char * ts_search_nocase(const char *hay, size_t n, const char *needle,
+                                         size_t m);
+
+TSC_EXTERN const char * ts_ac_init(ts_ac_t *ac, int nocase);
+TSC_EXTERN void         ts_ac_destroy(ts_ac_t *ac);
+TSC_EXTERN const char * ts_ac_add(ts_ac_t *ac, const char *pattern, size_t len);
+TSC_EXTERN const char * ts_ac_build(ts_ac_t *ac);
+TSC_EXTERN size_t       ts_ac_scan(const ts_ac_t *ac, const char *text, size_t n,
+                                   ts_ac_match_fn on_match, void *ud);
+
+#endif
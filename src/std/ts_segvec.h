@@ -0,0 +1,62 @@
+#ifndef TS_SEGVEC_H__
+#define TS_SEGVEC_H__
+
+/// ts_segvec is an append-only friendly vector that never moves its elements.
+/// storage is a list of segments growing geometrically (16, 32, 64, ... elements), so
+///   1. growing allocates one new segment, nothing is copied (bounded push latency,
+///      no 3x memory peak like a realloc of a multi GB ts_vec).
+///   2. &at(i) stays valid until the element is popped or the segvec is destroyed.
+/// element i lives in segment k = log2(i + 16) - 4, found with one leading zero count.
+
+// segments stay allocated on pop / clear, so refilling does not allocate again.
+// use segment(v, k, &p, &len) to walk the elements a segment at a time (e.g. memcpy out).
+
+#define TS_SEGVEC_SHIFT    4
+#define TS_SEGVEC_MAXSEG   (sizeof(size_t) * 8 - TS_SEGVEC_SHIFT)
+
+static inline unsigned ts_segvec_log2(size_t x) {
+  return (unsigned)(sizeof(unsigned long long) * 8 - 1 - __builtin_clzll((unsigned long long) x));
+}
+
+#define ts_make_segvec(name, type)                                                      \
+  typedef struct { size_t n, m; unsigned nseg; type *seg[TS_SEGVEC_MAXSEG]; } name##_t;  \
+  static inline void name##_init(name##_t *v) { v->n = v->m = 0; v->nseg = 0; }         \
+  static inline void name##_destroy(name##_t *v) {                                      \
+    for(unsigned k = 0 ; k < v->nseg ; ++k) free(v->seg[k]);                            \
+    v->n = v->m = 0; v->nseg = 0; }                                                     \
+  static inline void name##_clear(name##_t *v) { v->n = 0; }                            \
+  static inline size_t name##_size(name##_t *v) { return v->n; }                        \
+  static inline size_t name##_max(name##_t *v) { return v->m; }                         \
+  static inline type* name##_ptr(name##_t *v, size_t i) {                               \
+    size_t   j = i + ((size_t)1 << TS_SEGVEC_SHIFT);                                    \
+    unsigned h = ts_segvec_log2(j);                                                     \
+    return &v->seg[h - TS_SEGVEC_SHIFT][j - ((size_t)1 << h)]; }                        \
+  static inline type name##_at(name##_t *v, size_t i) { return *name##_ptr(v, i); }     \
+  static inline type name##_first(name##_t *v) { return v->seg[0][0]; }                 \
+  static inline type name##_last(name##_t *v) { return *name##_ptr(v, v->n - 1); }      \
+  static inline type name##_pop(name##_t *v) { return *name##_ptr(v, --(v->n)); }       \
+  static inline void name##_segment(name##_t *v, unsigned k, type **p, size_t *len) {   \
+    size_t start = (((size_t)1 << TS_SEGVEC_SHIFT) << k) - ((size_t)1 << TS_SEGVEC_SHIFT);\
+    size_t cap   = ((size_t)1 << TS_SEGVEC_SHIFT) << k;                                 \
+    *p   = v->seg[k];                                                                   \
+    *len = v->n <= start ? 0 : (v->n - start < cap ? v->n - start : cap); }             \
+  static inline const char* name##_grow(name##_t *v) {                                  \
+    size_t cap = ((size_t)1 << TS_SEGVEC_SHIFT) << v->nseg;                             \
+    tsunlikely_if(v->nseg == TS_SEGVEC_MAXSEG) return "OOM";                            \
+    tsunlikely_if( (v->seg[v->nseg] = (type*)malloc(sizeof(type) * cap)) == NULL )      \
+      return "OOM";                                                                     \
+    v->nseg++; v->m += cap; return NULL; }                                              \
+  static inline const char* name##_reserve(name##_t *v, size_t s) {                     \
+    const char *estr;                                                                   \
+    while(v->m < s)                                                                     \
+      tsunlikely_if( (estr = name##_grow(v)) != NULL )                                  \
+        return estr;                                                                    \
+    return NULL; }                                                                      \
+  static inline const char* name##_push(name##_t *v, type x) {                          \
+    const char *estr;                                                                   \
+    if(v->n == v->m)                                                                    \
+      tsunlikely_if( (estr = name##_grow(v)) != NULL )                                  \
+        return estr;                                                                    \
+    *name##_ptr(v, v->n++) = x; return NULL; }
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef TS_SLOTMAP_H__
+#define TS_SLOTMAP_H__
+
+/// ts_slotmap hands out stable handles to values that are stored densely.
+///   values live packed in a[0..n), so scanning them is a plain loop over an array
+///   (ts_vec_foreach works on a slotmap too), erase moves the last value into the hole.
+///   a handle is (generation << 32 | slot). the slot table maps it to the current index in a,
+///   the generation detects handles to values that were erased (slot reused or not).
+/// insert / get / erase are O(1), handles stay valid until the value is erased.
+
+// the generation of a slot is odd while the slot is in use, erase bumps it to even,
+// reuse bumps it to odd again. a handle is never 0, use it as "no handle".
+// handles to a slot go stale after 2^31 reuses of that slot (generation wraps).
+
+typedef uint64_t ts_slot_t;
+
+#define ts_slot_idx(h)   ((uint32_t)(h))
+#define ts_slot_gen(h)   ((uint32_t)((h) >> 32))
+#define ts_slot_make(gen, idx) (((uint64_t)(gen) << 32) | (uint32_t)(idx))
+#define TS_SLOT_NONE     UINT32_MAX
+
+typedef struct { uint32_t idx; uint32_t gen; } ts_slot_entry_t;  // idx: dense index or next free
+
+#define ts_make_slotmap(name, type)                                                     \
+  typedef struct {                                                                      \
+    size_t n, m; type *a; uint32_t *owner;           /* dense values, owner slot */     \
+    size_t nslots, mslots; ts_slot_entry_t *slots; uint32_t free_head;                  \
+  } name##_t;                                                                           \
+  static inline void name##_init(name##_t *s) {                                         \
+    s->n = s->m = 0; s->a = 0; s->owner = 0;                                            \
+    s->nslots = s->mslots = 0; s->slots = 0; s->free_head = TS_SLOT_NONE; }             \
+  static inline void name##_destroy(name##_t *s) {                                      \
+    free(s->a); free(s->owner); free(s->slots); name##_init(s); }                       \
+  static inline size_t name##_size(name##_t *s) { return s->n; }                        \
+  static inline type* name##_ptr(name##_t *s) { return s->a; }                          \
+  static inline ts_slot_t name##_handle_at(name##_t *s, size_t i) {                     \
+    uint32_t k = s->owner[i]; return ts_slot_make(s->slots[k].gen, k); }                \
+  static inline type* name##_get(name##_t *s, ts_slot_t h) {                            \
+    uint32_t k = ts_slot_idx(h);                                                        \
+    if(k >= s->nslots || s->slots[k].gen != ts_slot_gen(h)) return NULL;                \
+    return &s->a[s->slots[k].idx]; }                                                    \
+  static inline int name##_contains(name##_t *s, ts_slot_t h) {                         \
+    return name##_get(s, h) != NULL; }                                                  \
+  static inline const char* name##_reserve(name##_t *s, size_t cap) {                   \
+    type *a; uint32_t *o;                                                               \
+    if(cap <= s->m) return NULL;                                                        \
+    tsunlikely_if(cap > TS_SLOT_NONE) return "SLOTMAP FULL";                            \
+    tsunlikely_if( (a = (type*)realloc(s->a, sizeof(type) * cap)) == NULL )             \
+      return "OOM";                                                                     \
+    s->a = a;                                                                           \
+    tsunlikely_if( (o = (uint32_t*)realloc(s->owner, sizeof(uint32_t) * cap)) == NULL ) \
+      return "OOM";                                                                     \
+    s->owner = o; s->m = cap; return NULL; }                                            \
+  static inline const char* name##_insert(name##_t *s, type x, ts_slot_t *h) {          \
+    const char *estr; uint32_t k;                                                       \
+    if(s->n == s->m)                                                                    \
+      tsunlikely_if( (estr = name##_reserve(s, s->m ? s->m << 1 : 4)) != NULL )         \
+        return estr;                                                                    \
+    if(s->free_head != TS_SLOT_NONE) {                                                  \
+      k = s->free_head; s->free_head = s->slots[k].idx;                                 \
+    } else {                                                                            \
+      if(s->nslots == s->mslots) {                                                      \
+        size_t ms = s->mslots ? s->mslots << 1 : 4;                                     \
+        ts_slot_entry_t *tmp = (ts_slot_entry_t*)realloc(s->slots,                      \
+          sizeof(ts_slot_entry_t) * ms);                                                \
+        tsunlikely_if(tmp == NULL) return "OOM";                                        \
+        s->slots = tmp; s->mslots = ms;                                                 \
+      }                                                                                 \
+      k = (uint32_t)s->nslots++; s->slots[k].gen = 0;                                   \
+    }                                                                                   \
+    s->slots[k].gen++; s->slots[k].idx = (uint32_t)s->n;                                \
+    s->a[s->n] = x; s->owner[s->n] = k; s->n++;                                         \
+    if(h) *h = ts_slot_make(s->slots[k].gen, k);                                        \
+    return NULL; }                                                                      \
+  static inline void name##__release(name##_t *s, uint32_t k) {                         \
+    s->slots[k].gen++; s->slots[k].idx = s->free_head; s->free_head = k; }              \
+  static inline int name##_erase(name##_t *s, ts_slot_t h) {                            \
+    uint32_t k = ts_slot_idx(h), i, last;                                               \
+    if(k >= s->nslots || s->slots[k].gen != ts_slot_gen(h)) return 0;                   \
+    i = s->slots[k].idx; last = (uint32_t)--(s->n);                                     \
+    if(i != last) {                                                                     \
+      s->a[i] = s->a[last]; s->owner[i] = s->owner[last];                               \
+      s->slots[s->owner[i]].idx = i;                                                    \
+    }                                                                                   \
+    name##__release(s, k); return 1; }                                                  \
+  static inline void name##_clear(name##_t *s) {                                        \
+    for(size_t i = 0 ; i < s->n ; ++i) name##__release(s, s->owner[i]);                 \
+    s->n = 0; }
+
+#endif
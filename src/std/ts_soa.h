@@ -0,0 +1,93 @@
+#ifndef TS_SOA_H__
+#define TS_SOA_H__
+
+/// ts_soa is the structure-of-arrays sibling of ts_vec.
+///   ts_make_soa(pts, (float, x), (float, y), (int, id))
+/// generates one contiguous column per field that share a single n (size) and m (capacity):
+///   typedef struct { size_t n, m; float *x; float *y; int *id; } pts_t;
+/// scanning one field only pulls that column through the cache, and v->x is a plain
+/// float* that can be handed straight to a SIMD kernel.
+///
+/// rows go in and out as pts_row_t (a regular struct with the same fields), e.g.
+///   pts_push(&v, (pts_row_t){ .x = 1, .y = 2, .id = 3 });
+
+// CAUTION, same as ts_vec. if OOM happens in resize / push, you are responsible for cleaning up.
+// on OOM some columns may already have grown, but v->m is left unchanged, so v stays valid.
+// shrinking never fails, a column realloc returning NULL just keeps the larger block, and
+// resize to 0 frees every column.
+
+// up to 12 fields, (type, field) pairs
+#define TS_SOA_CALL(M, ...)         M(__VA_ARGS__)
+#define TS_SOA_UNPACK(...)          __VA_ARGS__
+#define TS_SOA_AP(M, t)             TS_SOA_CALL(M, TS_SOA_UNPACK t)
+#define TS_SOA_E1(M, a)             TS_SOA_AP(M, a)
+#define TS_SOA_E2(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E1(M, __VA_ARGS__)
+#define TS_SOA_E3(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E2(M, __VA_ARGS__)
+#define TS_SOA_E4(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E3(M, __VA_ARGS__)
+#define TS_SOA_E5(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E4(M, __VA_ARGS__)
+#define TS_SOA_E6(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E5(M, __VA_ARGS__)
+#define TS_SOA_E7(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E6(M, __VA_ARGS__)
+#define TS_SOA_E8(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E7(M, __VA_ARGS__)
+#define TS_SOA_E9(M, a, ...)        TS_SOA_AP(M, a) TS_SOA_E8(M, __VA_ARGS__)
+#define TS_SOA_E10(M, a, ...)       TS_SOA_AP(M, a) TS_SOA_E9(M, __VA_ARGS__)
+#define TS_SOA_E11(M, a, ...)       TS_SOA_AP(M, a) TS_SOA_E10(M, __VA_ARGS__)
+#define TS_SOA_E12(M, a, ...)       TS_SOA_AP(M, a) TS_SOA_E11(M, __VA_ARGS__)
+#define TS_SOA_NARG(...)            TS_SOA_NARG_(__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TS_SOA_NARG_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, N, ...) N
+#define TS_SOA_CAT(a, b)            TS_SOA_CAT_(a, b)
+#define TS_SOA_CAT_(a, b)           a##b
+#define TS_SOA_EACH(M, ...)         TS_SOA_CAT(TS_SOA_E, TS_SOA_NARG(__VA_ARGS__))(M, __VA_ARGS__)
+
+// per field snippets, they rely on the local names used in ts_make_soa (v, s, i, j, row, ok)
+#define TS_SOA_DECL_COL(type, f)    type *f;
+#define TS_SOA_DECL_ROW(type, f)    type f;
+#define TS_SOA_NULL(type, f)        v->f = 0;
+#define TS_SOA_FREE(type, f)        free(v->f);
+#define TS_SOA_RESIZE(type, f)      if(ok) { type *tmp = (type*)realloc(v->f, sizeof(type) * s); \
+                                      if(tmp) v->f = tmp; else if(s > v->m) ok = 0; }
+#define TS_SOA_STORE(type, f)       v->f[i] = row.f;
+#define TS_SOA_LOAD(type, f)        row.f = v->f[i];
+#define TS_SOA_MOVE(type, f)        v->f[i] = v->f[j];
+#define TS_SOA_ERASE(type, f)       memmove(v->f + i, v->f + i + 1, sizeof(type) * (v->n - i - 1));
+
+#define ts_make_soa(name, ...)                                                          \
+  typedef struct { size_t n, m; TS_SOA_EACH(TS_SOA_DECL_COL, __VA_ARGS__) } name##_t;   \
+  typedef struct { TS_SOA_EACH(TS_SOA_DECL_ROW, __VA_ARGS__) } name##_row_t;            \
+  static inline void name##_init(name##_t *v) {                                         \
+    v->n = 0; v->m = 0; TS_SOA_EACH(TS_SOA_NULL, __VA_ARGS__) }                         \
+  static inline void name##_destroy(name##_t *v) {                                      \
+    TS_SOA_EACH(TS_SOA_FREE, __VA_ARGS__) }                                             \
+  static inline void name##_clear(name##_t *v) { v->n = 0; }                            \
+  static inline size_t name##_size(name##_t *v) { return v->n; }                        \
+  static inline size_t name##_max(name##_t *v) { return v->m; }                         \
+  static inline const char* name##_resize(name##_t *v, size_t s) {                      \
+    int ok = 1;                                                                         \
+    if(s == 0) {                                                                        \
+      TS_SOA_EACH(TS_SOA_FREE, __VA_ARGS__) TS_SOA_EACH(TS_SOA_NULL, __VA_ARGS__)       \
+      v->n = 0; v->m = 0; return NULL; }                                                \
+    TS_SOA_EACH(TS_SOA_RESIZE, __VA_ARGS__)                                             \
+    tsunlikely_if(!ok) return "OOM";                                                    \
+    v->m = s; if(v->n > s) v->n = s; return NULL; }                                     \
+  static inline const char* name##_compact(name##_t *v) {                               \
+    return name##_resize(v, v->n); }                                                    \
+  static inline name##_row_t name##_at(name##_t *v, size_t i) {                         \
+    name##_row_t row; TS_SOA_EACH(TS_SOA_LOAD, __VA_ARGS__) return row; }               \
+  static inline void name##_set(name##_t *v, size_t i, name##_row_t row) {              \
+    TS_SOA_EACH(TS_SOA_STORE, __VA_ARGS__) }                                            \
+  static inline const char* name##_push(name##_t *v, name##_row_t row) {                \
+    const char *estr; size_t i;                                                         \
+    if(v->n == v->m) {                                                                  \
+      size_t m = v->m ? v->m << 1 : 4;                                                  \
+      tsunlikely_if( (estr = name##_resize(v, m)) != NULL )                             \
+        return estr;                                                                    \
+    }                                                                                   \
+    i = v->n++; TS_SOA_EACH(TS_SOA_STORE, __VA_ARGS__) return NULL; }                   \
+  static inline name##_row_t name##_pop(name##_t *v) {                                  \
+    return name##_at(v, --(v->n)); }                                                    \
+  static inline void name##_erase(name##_t *v, size_t i) {                              \
+    TS_SOA_EACH(TS_SOA_ERASE, __VA_ARGS__) v->n--; }                                    \
+  static inline void name##_swap_erase(name##_t *v, size_t i) {                         \
+    size_t j = --(v->n);                                                                \
+    if(i != j) { TS_SOA_EACH(TS_SOA_MOVE, __VA_ARGS__) } }
+
+#endif
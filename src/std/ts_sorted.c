@@ -0,0 +1,88 @@
+#include "libts.h"
+
+// block intersection (Schlegel et al. / Lemire): compare a block of a against every rotation
+// of a block of b, emit the matches, then drop whichever block ends first (both on a tie).
+// this only needs equality in the vector unit, so signed and unsigned share the match
+// kernels. signedness only matters for the scalar compare that decides which block to drop.
+
+#if defined(__SSE2__)
+#define TS_SORTED_W32 4
+static inline unsigned ts_sorted_match32(const void *pa, const void *pb) {
+  __m128i a = _mm_loadu_si128((const __m128i *) pa);
+  __m128i b = _mm_loadu_si128((const __m128i *) pb);
+  __m128i r = _mm_cmpeq_epi32(a, b);
+  r = _mm_or_si128(r, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1))));
+  r = _mm_or_si128(r, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+  r = _mm_or_si128(r, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3))));
+  return (unsigned) _mm_movemask_ps(_mm_castsi128_ps(r));
+}
+#endif
+
+#if defined(__AVX2__)
+#define TS_SORTED_W64 4
+static inline unsigned ts_sorted_match64(const void *pa, const void *pb) {
+  __m256i a = _mm256_loadu_si256((const __m256i *) pa);
+  __m256i b = _mm256_loadu_si256((const __m256i *) pb);
+  __m256i r = _mm256_cmpeq_epi64(a, b);
+  r = _mm256_or_si256(r, _mm256_cmpeq_epi64(a, _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1))));
+  r = _mm256_or_si256(r, _mm256_cmpeq_epi64(a, _mm256_permute4x64_epi64(b, _MM_SHUFFLE(1, 0, 3, 2))));
+  r = _mm256_or_si256(r, _mm256_cmpeq_epi64(a, _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3))));
+  return (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(r));
+}
+#elif defined(__SSE2__)
+// no 64-bit compare in SSE2, a 64-bit lane is equal when both of its 32-bit halves are
+#define TS_SORTED_W64 2
+static inline unsigned ts_sorted_match64(const void *pa, const void *pb) {
+  __m128i a  = _mm_loadu_si128((const __m128i *) pa);
+  __m128i b  = _mm_loadu_si128((const __m128i *) pb);
+  __m128i e0 = _mm_cmpeq_epi32(a, b);
+  __m128i e1 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2)));
+  e0 = _mm_and_si128(e0, _mm_shuffle_epi32(e0, _MM_SHUFFLE(2, 3, 0, 1)));
+  e1 = _mm_and_si128(e1, _mm_shuffle_epi32(e1, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (unsigned) _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(e0, e1)));
+}
+#endif
+
+#define TS_SORTED_SCALAR_TAIL()                                                         \
+  while(i < na && j < nb) {                                                             \
+    if(a[i] < b[j])      i++;                                                           \
+    else if(b[j] < a[i]) j++;                                                           \
+    else { out[k++] = a[i]; i++; j++; }                                                 \
+  }                                                                                     \
+  return k;
+
+#define TS_SORTED_INTERSECT(fname, type, W, match)                                      \
+size_t fname(const type *a, size_t na, const type *b, size_t nb, type *out) {           \
+  size_t i = 0, j = 0, k = 0;                                                           \
+  unsigned m;                                                                           \
+  while(i + (W) <= na && j + (W) <= nb) {                                               \
+    type amax = a[i + (W) - 1], bmax = b[j + (W) - 1];                                  \
+    for(m = match(a + i, b + j) ; m ; m &= m - 1)                                       \
+      out[k++] = a[i + __builtin_ctz(m)];                                               \
+    i += (amax <= bmax) * (W);                                                          \
+    j += (bmax <= amax) * (W);                                                          \
+  }                                                                                     \
+  TS_SORTED_SCALAR_TAIL()                                                               \
+}
+
+#define TS_SORTED_INTERSECT_SCALAR(fname, type)                                         \
+size_t fname(const type *a, size_t na, const type *b, size_t nb, type *out) {           \
+  size_t i = 0, j = 0, k = 0;                                                           \
+  TS_SORTED_SCALAR_TAIL()                                                               \
+}
+
+#ifdef TS_SORTED_W32
+TS_SORTED_INTERSECT(ts_sorted_intersect_i32, int32_t,  TS_SORTED_W32, ts_sorted_match32)
+TS_SORTED_INTERSECT(ts_sorted_intersect_u32, uint32_t, TS_SORTED_W32, ts_sorted_match32)
+#else
+TS_SORTED_INTERSECT_SCALAR(ts_sorted_intersect_i32, int32_t)
+TS_SORTED_INTERSECT_SCALAR(ts_sorted_intersect_u32, uint32_t)
+#endif
+
+#ifdef TS_SORTED_W64
+TS_SORTED_INTERSECT(ts_sorted_intersect_i64, int64_t,  TS_SORTED_W64, ts_sorted_match64)
+TS_SORTED_INTERSECT(ts_sorted_intersect_u64, uint64_t, TS_SORTED_W64, ts_sorted_match64)
+#else
+TS_SORTED_INTERSECT_SCALAR(ts_sorted_intersect_i64, int64_t)
+TS_SORTED_INTERSECT_SCALAR(ts_sorted_intersect_u64, uint64_t)
+#endif
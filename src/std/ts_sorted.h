@@ -0,0 +1,159 @@
+#ifndef TS_SORTED_H__
+#define TS_SORTED_H__
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// search and set algorithms over sorted vecs made with ts_make_vec(name, type).
+///   ts_make_vec_sorted(name, type, less_fn)   any type, ordered by less_fn
+///   ts_make_vec_sorted_int(name, type)        32 / 64-bit integers, SIMD set_intersection
+/// lower_bound / upper_bound are branchless (the loop compiles to cmov, no mispredicts).
+/// merge / set_union / set_intersection / set_difference write into dst, which is grown as
+/// needed and must not be one of the inputs.
+
+// set_* expect sets, i.e. sorted and without duplicates (run unique first).
+// set_intersection gallops through the larger input when one side is more than
+// TS_SORTED_GALLOP_RATIO times smaller, that is O(small * log(large)) instead of O(small + large).
+
+#ifndef TS_SORTED_GALLOP_RATIO
+  #define TS_SORTED_GALLOP_RATIO 32
+#endif
+
+#define ts_sorted_less(a, b) ((a) < (b))
+
+TSC_EXTERN size_t ts_sorted_intersect_i32(const int32_t *a, size_t na,
+                                          const int32_t *b, size_t nb, int32_t *out);
+TSC_EXTERN size_t ts_sorted_intersect_u32(const uint32_t *a, size_t na,
+                                          const uint32_t *b, size_t nb, uint32_t *out);
+TSC_EXTERN size_t ts_sorted_intersect_i64(const int64_t *a, size_t na,
+                                          const int64_t *b, size_t nb, int64_t *out);
+TSC_EXTERN size_t ts_sorted_intersect_u64(const uint64_t *a, size_t na,
+                                          const uint64_t *b, size_t nb, uint64_t *out);
+
+#define ts_make_vec_sorted(name, type, less_fn)                                         \
+  ts_make_vec_sorted_ext(name, type, less_fn, name##__intersect_merge)
+
+#define ts_make_vec_sorted_int(name, type)                                              \
+  static inline size_t name##__intersect_simd(const type *a, size_t na,                 \
+    const type *b, size_t nb, type *out);                                               \
+  ts_make_vec_sorted_ext(name, type, ts_sorted_less, name##__intersect_simd)            \
+  static inline size_t name##__intersect_simd(const type *a, size_t na,                 \
+    const type *b, size_t nb, type *out) {                                              \
+    int sgn = (type)-1 < (type)1;                                                       \
+    if(sizeof(type) == 4 && sgn) return ts_sorted_intersect_i32(                        \
+      (const int32_t*)a, na, (const int32_t*)b, nb, (int32_t*)out);                     \
+    if(sizeof(type) == 4)        return ts_sorted_intersect_u32(                        \
+      (const uint32_t*)a, na, (const uint32_t*)b, nb, (uint32_t*)out);                  \
+    if(sizeof(type) == 8 && sgn) return ts_sorted_intersect_i64(                        \
+      (const int64_t*)a, na, (const int64_t*)b, nb, (int64_t*)out);                     \
+    if(sizeof(type) == 8)        return ts_sorted_intersect_u64(                        \
+      (const uint64_t*)a, na, (const uint64_t*)b, nb, (uint64_t*)out);                  \
+    return name##__intersect_merge(a, na, b, nb, out); }
+
+#define ts_make_vec_sorted_ext(name, type, less_fn, intersect_fn)                       \
+  /* first index in a[0..n) with !(a[i] < x) */                                         \
+  static inline size_t name##__lb(const type *a, size_t n, type x) {                    \
+    const type *base = a; size_t half;                                                  \
+    if(n == 0) return 0;                                                                \
+    while(n > 1) {                                                                      \
+      half = n >> 1;                                                                    \
+      base = (less_fn(base[half], x)) ? base + half : base;                             \
+      n -= half;                                                                        \
+    }                                                                                   \
+    return (size_t)(base - a) + (less_fn(*base, x)); }                                  \
+  static inline size_t name##__ub(const type *a, size_t n, type x) {                    \
+    const type *base = a; size_t half;                                                  \
+    if(n == 0) return 0;                                                                \
+    while(n > 1) {                                                                      \
+      half = n >> 1;                                                                    \
+      base = (less_fn(x, base[half])) ? base : base + half;                             \
+      n -= half;                                                                        \
+    }                                                                                   \
+    return (size_t)(base - a) + !(less_fn(x, *base)); }                                 \
+  static inline size_t name##_lower_bound(name##_t *v, type x) {                        \
+    return name##__lb(v->a, v->n, x); }                                                 \
+  static inline size_t name##_upper_bound(name##_t *v, type x) {                        \
+    return name##__ub(v->a, v->n, x); }                                                 \
+  static inline int name##_contains(name##_t *v, type x) {                              \
+    size_t i = name##__lb(v->a, v->n, x);                                               \
+    return i < v->n && !(less_fn(x, v->a[i])); }                                        \
+  static inline void name##_unique(name##_t *v) {                                       \
+    size_t j = 0;                                                                       \
+    for(size_t i = 0 ; i < v->n ; ++i)                                                  \
+      if(j == 0 || less_fn(v->a[j - 1], v->a[i])) v->a[j++] = v->a[i];                  \
+    v->n = j; }                                                                         \
+  /* exponential probe from lo, then binary search the bracket */                       \
+  static inline size_t name##__gallop(const type *a, size_t lo, size_t n, type x) {     \
+    size_t hi = lo, step = 1;                                                           \
+    while(hi < n && less_fn(a[hi], x)) { lo = hi + 1; hi += step; step <<= 1; }         \
+    if(hi > n) hi = n;                                                                  \
+    return lo + name##__lb(a + lo, hi - lo, x); }                                       \
+  static inline size_t name##__intersect_merge(const type *a, size_t na,                \
+    const type *b, size_t nb, type *out) {                                              \
+    size_t i = 0, j = 0, k = 0;                                                         \
+    while(i < na && j < nb) {                                                           \
+      if(less_fn(a[i], b[j]))      i++;                                                 \
+      else if(less_fn(b[j], a[i])) j++;                                                 \
+      else { out[k++] = a[i]; i++; j++; }                                               \
+    }                                                                                   \
+    return k; }                                                                         \
+  static inline size_t name##__intersect_gallop(const type *s, size_t ns,               \
+    const type *l, size_t nl, type *out) {                                              \
+    size_t j = 0, k = 0;                                                                \
+    for(size_t i = 0 ; i < ns && j < nl ; ++i) {                                        \
+      j = name##__gallop(l, j, nl, s[i]);                                               \
+      if(j < nl && !(less_fn(s[i], l[j]))) out[k++] = l[j++];                           \
+    }                                                                                   \
+    return k; }                                                                         \
+  static inline const char* name##__reserve(name##_t *v, size_t s) {                    \
+    return v->m < s ? name##_resize(v, s) : NULL; }                                     \
+  static inline const char* name##_merge(name##_t *dst, name##_t *a, name##_t *b) {     \
+    const char *estr; size_t i = 0, j = 0, k = 0;                                       \
+    tsunlikely_if( (estr = name##__reserve(dst, a->n + b->n)) != NULL )                 \
+      return estr;                                                                      \
+    while(i < a->n && j < b->n)                                                         \
+      dst->a[k++] = (less_fn(b->a[j], a->a[i])) ? b->a[j++] : a->a[i++];                \
+    while(i < a->n) dst->a[k++] = a->a[i++];                                            \
+    while(j < b->n) dst->a[k++] = b->a[j++];                                            \
+    dst->n = k; return NULL; }                                                          \
+  static inline const char* name##_set_union(name##_t *dst, name##_t *a, name##_t *b) { \
+    const char *estr; size_t i = 0, j = 0, k = 0;                                       \
+    tsunlikely_if( (estr = name##__reserve(dst, a->n + b->n)) != NULL )                 \
+      return estr;                                                                      \
+    while(i < a->n && j < b->n) {                                                       \
+      if(less_fn(a->a[i], b->a[j]))      dst->a[k++] = a->a[i++];                       \
+      else if(less_fn(b->a[j], a->a[i])) dst->a[k++] = b->a[j++];                       \
+      else { dst->a[k++] = a->a[i++]; j++; }                                            \
+    }                                                                                   \
+    while(i < a->n) dst->a[k++] = a->a[i++];                                            \
+    while(j < b->n) dst->a[k++] = b->a[j++];                                            \
+    dst->n = k; return NULL; }                                                          \
+  static inline const char* name##_set_intersection(name##_t *dst, name##_t *a,         \
+    name##_t *b) {                                                                      \
+    const char *estr;                                                                   \
+    tsunlikely_if( (estr = name##__reserve(dst, a->n < b->n ? a->n : b->n)) != NULL )   \
+      return estr;                                                                      \
+    if(a->n * TS_SORTED_GALLOP_RATIO < b->n)                                            \
+      dst->n = name##__intersect_gallop(a->a, a->n, b->a, b->n, dst->a);                \
+    else if(b->n * TS_SORTED_GALLOP_RATIO < a->n)                                       \
+      dst->n = name##__intersect_gallop(b->a, b->n, a->a, a->n, dst->a);                \
+    else                                                                                \
+      dst->n = intersect_fn(a->a, a->n, b->a, b->n, dst->a);                            \
+    return NULL; }                                                                      \
+  static inline const char* name##_set_difference(name##_t *dst, name##_t *a,           \
+    name##_t *b) {                                                                      \
+    const char *estr; size_t i = 0, j = 0, k = 0;                                       \
+    tsunlikely_if( (estr = name##__reserve(dst, a->n)) != NULL )                        \
+      return estr;                                                                      \
+    while(i < a->n && j < b->n) {                                                       \
+      if(less_fn(a->a[i], b->a[j]))      dst->a[k++] = a->a[i++];                       \
+      else if(less_fn(b->a[j], a->a[i])) j++;                                           \
+      else { i++; j++; }                                                                \
+    }                                                                                   \
+    while(i < a->n) dst->a[k++] = a->a[i++];                                            \
+    dst->n = k; return NULL; }
+
+#endif
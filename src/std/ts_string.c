@@ -1,51 +1,146 @@
 #include "libts.h"
 
+// single pass, stops at the first mismatch instead of measuring start first
 int   ts_startswith(const char *s, const char *start) {
-  return strncmp(start, s, strlen(start)) ? 0 : 1;
+  while(*start)
+    if(*s++ != *start++) return 0;
+  return 1;
 }
 
-char* ts_trimleft_inplace(char *str) {
-  int len = strlen(str);
-  tsunlikely_if(len == 0) return str;
-  char *cur = str;
-  while (*cur && isspace(*cur)) {
-    ++cur;
-    --len;
+int   ts_endswith(const char *s, const char *end) {
+  return ts_sv_endswith(ts_sv_cstr(s), ts_sv_cstr(end));
+}
+
+// ASCII helpers shared by the scalar paths and the tails of the vector loops
+#define TS_STR_ISSPACE(c) ((c) == ' ' || ((unsigned char)(c) - 9u) < 5u)
+#define TS_STR_CASE(c, lo) ((unsigned)(unsigned char)(c) - (unsigned char)(lo) < 26u ? (c) ^ 0x20 : (c))
+
+#if defined(__SSE2__)
+// flips bit 0x20 of the bytes in [lo, lo + 25]. bytes >= 0x80 compare as negative, never match
+static inline __m128i ts_str_case16(__m128i v, char lo) {
+  __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1))),
+                            _mm_cmplt_epi8(v, _mm_set1_epi8((char)(lo + 26))));
+  return _mm_xor_si128(v, _mm_and_si128(m, _mm_set1_epi8(0x20)));
+}
+
+// bit i set when byte i is one of ' ', \t, \n, \v, \f, \r
+static inline unsigned ts_str_space16(__m128i v) {
+  __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                           _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(8)),
+                                         _mm_cmplt_epi8(v, _mm_set1_epi8(14))));
+  return (unsigned) _mm_movemask_epi8(m);
+}
+#endif
+
+#if defined(__AVX2__)
+static inline __m256i ts_str_case32(__m256i v, char lo) {
+  __m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8((char)(lo - 1))),
+                               _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(lo + 26)), v));
+  return _mm256_xor_si256(v, _mm256_and_si256(m, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+static void ts_str_case_n(char *str, size_t n, char lo) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for( ; i + 32 <= n ; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(str + i));
+    _mm256_storeu_si256((__m256i *)(str + i), ts_str_case32(v, lo));
+  }
+#endif
+#if defined(__SSE2__)
+  for( ; i + 16 <= n ; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(str + i));
+    _mm_storeu_si128((__m128i *)(str + i), ts_str_case16(v, lo));
+  }
+#endif
+  for( ; i < n ; i++)
+    str[i] = TS_STR_CASE(str[i], lo);
+}
+
+// libc strlen is vectorized already, and staying inside the string keeps ASan and
+// valgrind quiet (an aligned load past the NUL is harmless but out of bounds)
+static size_t ts_str_case(char *str, char lo) {
+  size_t n = strlen(str);
+  ts_str_case_n(str, n, lo);
+  return n;
+}
+
+// index of the first non space byte, n if all of them are spaces
+static size_t ts_str_skip_space(const char *s, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for( ; i + 16 <= n ; i += 16) {
+    unsigned m = ~ts_str_space16(_mm_loadu_si128((const __m128i *)(s + i))) & 0xffff;
+    if(m) return i + (size_t)__builtin_ctz(m);
+  }
+#endif
+  while(i < n && TS_STR_ISSPACE(s[i])) i++;
+  return i;
+}
+
+// length once the trailing spaces are dropped
+static size_t ts_str_skip_space_rev(const char *s, size_t n) {
+#if defined(__SSE2__)
+  for( ; n >= 16 ; n -= 16) {
+    unsigned m = ~ts_str_space16(_mm_loadu_si128((const __m128i *)(s + n - 16))) & 0xffff;
+    if(m) return n - 16 + 32 - (size_t)__builtin_clz(m);
   }
-  if (str != cur) memmove(str, cur, len + 1);
+#endif
+  while(n > 0 && TS_STR_ISSPACE(s[n - 1])) n--;
+  return n;
+}
+
+size_t ts_trimleft_inplace_n(char *s, size_t n) {
+  size_t i = ts_str_skip_space(s, n);
+  if(i == 0) return n;
+  memmove(s, s + i, n - i);
+  s[n - i] = '\0';
+  return n - i;
+}
+
+size_t ts_trimright_inplace_n(char *s, size_t n) {
+  size_t len = ts_str_skip_space_rev(s, n);
+  if(len < n) s[len] = '\0';
+  return len;
+}
+
+size_t ts_trim_inplace_n(char *s, size_t n) {
+  return ts_trimleft_inplace_n(s, ts_trimright_inplace_n(s, n));
+}
+
+char* ts_trimleft_inplace(char *str) {
+  ts_trimleft_inplace_n(str, strlen(str));
   return str;
 }
 
 char* ts_trimright_inplace(char *str) {
-  int len = strlen(str);
-  tsunlikely_if(len == 0) return str;
-  char *cur = str + len - 1;
-  while (cur != str && isspace(*cur)) --cur;
-  cur[isspace(*cur) ? 0 : 1] = '\0';
+  ts_trimright_inplace_n(str, strlen(str));
   return str;
 }
 
 char* ts_trim_inplace(char *s) {
-  ts_trimright_inplace(s);
-  ts_trimleft_inplace(s);
+  ts_trim_inplace_n(s, strlen(s));
   return s;
 }
 
+char* ts_upper_inplace_n(char *str, size_t n) {
+  ts_str_case_n(str, n, 'a');
+  return str;
+}
+
+char* ts_lower_inplace_n(char *str, size_t n) {
+  ts_str_case_n(str, n, 'A');
+  return str;
+}
+
 char* ts_upper_inplace(char *str) {
-  for (int i = 0, len = strlen(str); i < len; i++) {
-    if (islower(str[i])) {
-      str[i] &= ~0x20;
-    }
-  }
+  ts_str_case(str, 'a');
   return str;
 }
 
 char* ts_lower_inplace(char *str) {
-  for (int i = 0, len = strlen(str); i < len; i++) {
-    if (isupper(str[i])) {
-      str[i] |= 0x20;
-    }
-  }
+  ts_str_case(str, 'A');
   return str;
 }
 
@@ -1,6 +1,17 @@
 #ifndef TS_STRING_H__
 #define TS_STRING_H__
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// case conversion and trimming are ASCII only (the "C" locale behaviour of isupper / isspace),
+// vectorized with SSE2 / AVX2 when available.
+// the _n variants take the length instead of calling strlen, trim*_n return the new length
+// and NUL terminate when the string got shorter.
+
 TSC_EXTERN int          ts_startswith(const char *s, const char *start);
 TSC_EXTERN int          ts_endswith(const char *s, const char *end);
 TSC_EXTERN char *       ts_trimleft_inplace(char *s);
@@ -8,6 +19,11 @@ TSC_EXTERN char *       ts_trimright_inplace(char *s);
 TSC_EXTERN char *       ts_trim_inplace(char *s);
 TSC_EXTERN char *       ts_upper_inplace(char *str);
 TSC_EXTERN char *       ts_lower_inplace(char *str);
+TSC_EXTERN char *       ts_upper_inplace_n(char *str, size_t n);
+TSC_EXTERN char *       ts_lower_inplace_n(char *str, size_t n);
+TSC_EXTERN size_t       ts_trimleft_inplace_n(char *s, size_t n);
+TSC_EXTERN size_t       ts_trimright_inplace_n(char *s, size_t n);
+TSC_EXTERN size_t       ts_trim_inplace_n(char *s, size_t n);
 TSC_EXTERN const char * ts_trim(char **ret, const char *s);
 TSC_EXTERN const char * ts_strdup(char **ret, const char *s);
 TSC_EXTERN const char * ts_strndup(char **ret, const char *s, size_t n);
@@ -0,0 +1,130 @@
+#ifndef TS_STRVIEW_H__
+#define TS_STRVIEW_H__
+
+/// ts_strview_t is a non-owning slice of a string: pointer + length, no NUL required.
+/// trim / substr / split return views into the same buffer, nothing is allocated or copied.
+/// materialize with ts_sv_to_sds / ts_sv_dup when the bytes must outlive the buffer.
+///
+///   ts_sv_split_t it;
+///   ts_strview_t  tok;
+///   ts_sv_split_init(&it, ts_sv_cstr(line), ts_sv_cstr(", "));
+///   while(ts_sv_split_next(&it, &tok))
+///     printf("%.*s\n", (int) tok.n, tok.p);
+
+// whitespace is ASCII (' ', \t, \n, \v, \f, \r) like the ts_trim*_inplace functions.
+
+#define TS_SV_NPOS ((size_t) -1)
+
+typedef struct ts_strview {
+  const char *p;
+  size_t      n;
+} ts_strview_t;
+
+typedef struct {
+  ts_strview_t rest;
+  ts_strview_t sep;
+  int          done;
+} ts_sv_split_t;
+
+static inline ts_strview_t ts_sv(const char *p, size_t n) {
+  ts_strview_t v = { p, n };
+  return v;
+}
+
+static inline ts_strview_t ts_sv_cstr(const char *s) { return ts_sv(s, strlen(s)); }
+static inline ts_strview_t ts_sv_sds(const sds s)    { return ts_sv(s, sdslen(s)); }
+
+static inline int ts_sv_isspace(char c) {
+  return c == ' ' || ((unsigned)(unsigned char) c - 9u) < 5u;
+}
+
+static inline ts_strview_t ts_sv_trimleft(ts_strview_t v) {
+  while(v.n && ts_sv_isspace(*v.p)) { v.p++; v.n--; }
+  return v;
+}
+
+static inline ts_strview_t ts_sv_trimright(ts_strview_t v) {
+  while(v.n && ts_sv_isspace(v.p[v.n - 1])) v.n--;
+  return v;
+}
+
+static inline ts_strview_t ts_sv_trim(ts_strview_t v) {
+  return ts_sv_trimleft(ts_sv_trimright(v));
+}
+
+// start / len are clamped to the view
+static inline ts_strview_t ts_sv_substr(ts_strview_t v, size_t start, size_t len) {
+  if(start > v.n) start = v.n;
+  if(len > v.n - start) len = v.n - start;
+  return ts_sv(v.p + start, len);
+}
+
+static inline ts_strview_t ts_sv_trunc(ts_strview_t v, size_t n) {
+  return ts_sv(v.p, n < v.n ? n : v.n);
+}
+
+static inline int ts_sv_startswith(ts_strview_t v, ts_strview_t prefix) {
+  return prefix.n <= v.n && memcmp(v.p, prefix.p, prefix.n) == 0;
+}
+
+static inline int ts_sv_endswith(ts_strview_t v, ts_strview_t suffix) {
+  return suffix.n <= v.n && memcmp(v.p + v.n - suffix.n, suffix.p, suffix.n) == 0;
+}
+
+static inline int ts_sv_eq(ts_strview_t a, ts_strview_t b) {
+  return a.n == b.n && memcmp(a.p, b.p, a.n) == 0;
+}
+
+// memcmp order, a shorter view sorts before a longer one it is a prefix of
+static inline int ts_sv_cmp(ts_strview_t a, ts_strview_t b) {
+  int r = memcmp(a.p, b.p, a.n < b.n ? a.n : b.n);
+  return r ? r : (a.n > b.n) - (a.n < b.n);
+}
+
+static inline size_t ts_sv_find_char(ts_strview_t v, char c) {
+  const char *hit = v.n ? (const char *) memchr(v.p, c, v.n) : NULL;
+  return hit ? (size_t)(hit - v.p) : TS_SV_NPOS;
+}
+
+static inline size_t ts_sv_find(ts_strview_t v, ts_strview_t needle) {
+  const char *hit;
+  if(needle.n == 0) return 0;
+  if(needle.n == 1) return ts_sv_find_char(v, needle.p[0]);
+  hit = (const char *) memmem(v.p, v.n, needle.p, needle.n);
+  return hit ? (size_t)(hit - v.p) : TS_SV_NPOS;
+}
+
+// an empty separator yields the whole view as a single token
+static inline void ts_sv_split_init(ts_sv_split_t *it, ts_strview_t v, ts_strview_t sep) {
+  it->rest = v;
+  it->sep  = sep;
+  it->done = 0;
+}
+
+static inline int ts_sv_split_next(ts_sv_split_t *it, ts_strview_t *tok) {
+  size_t i;
+  if(it->done) return 0;
+  i = it->sep.n ? ts_sv_find(it->rest, it->sep) : TS_SV_NPOS;
+  if(i == TS_SV_NPOS) {
+    *tok     = it->rest;
+    it->done = 1;
+  } else {
+    *tok       = ts_sv(it->rest.p, i);
+    it->rest.p += i + it->sep.n;
+    it->rest.n -= i + it->sep.n;
+  }
+  return 1;
+}
+
+// NULL on OOM, like the other sds constructors
+static inline sds ts_sv_to_sds(ts_strview_t v) { return sdsnewlen(v.p, v.n); }
+
+static inline const char * ts_sv_dup(char **ret, ts_strview_t v) {
+  tsunlikely_if( (*ret = (char *) malloc(v.n + 1)) == NULL )
+    return "OOM";
+  memcpy(*ret, v.p, v.n);
+  (*ret)[v.n] = '\0';
+  return NULL;
+}
+
+#endif
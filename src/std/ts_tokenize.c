@@ -0,0 +1,87 @@
+#include "libts.h"
+
+#if defined(__AVX2__)
+  #define TS_TOK_W 32
+#elif defined(__SSE2__)
+  #define TS_TOK_W 16
+#endif
+
+void ts_tok_init(ts_tok_t *t, const char *buf, size_t n, const char *sep, size_t sepn) {
+  t->buf  = buf;
+  t->n    = n;
+  t->sep  = sep;
+  t->sepn = sepn;
+  t->pos  = 0;
+  t->scan = 0;
+  t->base = 0;
+  t->mask = 0;
+  t->done = n == 0;
+}
+
+#ifdef TS_TOK_W
+// separator bits of the next block, the last (partial) block is compared byte by byte
+static inline void ts_tok_refill(ts_tok_t *t) {
+  const char c = t->sep[0];
+  size_t     left = t->n - t->scan;
+  t->base = t->scan;
+  if(left >= TS_TOK_W) {
+#if defined(__AVX2__)
+    __m256i v = _mm256_loadu_si256((const __m256i *)(t->buf + t->scan));
+    t->mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+#else
+    __m128i v = _mm_loadu_si128((const __m128i *)(t->buf + t->scan));
+    t->mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+#endif
+    t->scan += TS_TOK_W;
+  } else {
+    t->mask = 0;
+    for(size_t i = 0 ; i < left ; i++)
+      t->mask |= (uint64_t)(t->buf[t->scan + i] == c) << i;
+    t->scan = t->n;
+  }
+}
+#endif
+
+// offset of the next separator at or after t->pos, t->n if there is none
+static inline size_t ts_tok_find(ts_tok_t *t) {
+  if(t->sepn == 1) {
+#ifdef TS_TOK_W
+    for(;;) {
+      if(t->mask) {
+        size_t i = t->base + (size_t) __builtin_ctzll(t->mask);
+        t->mask &= t->mask - 1;
+        return i;
+      }
+      if(t->scan >= t->n) return t->n;
+      ts_tok_refill(t);
+    }
+#else
+    const char *hit = (const char *) memchr(t->buf + t->pos, t->sep[0], t->n - t->pos);
+    return hit ? (size_t)(hit - t->buf) : t->n;
+#endif
+  } else {
+    const char *hit = (const char *) memmem(t->buf + t->pos, t->n - t->pos, t->sep, t->sepn);
+    return hit ? (size_t)(hit - t->buf) : t->n;
+  }
+}
+
+static inline int ts_tok_step(ts_tok_t *t, ts_token_t *tok) {
+  size_t i;
+  if(t->done) return 0;
+  i = t->sepn ? ts_tok_find(t) : t->n;
+  tok->off = t->pos;
+  tok->len = i - t->pos;
+  if(i == t->n) t->done = 1;
+  else          t->pos  = i + t->sepn;
+  return 1;
+}
+
+int ts_tok_next(ts_tok_t *t, ts_token_t *tok) {
+  return ts_tok_step(t, tok);
+}
+
+size_t ts_tok_batch(ts_tok_t *t, ts_token_t *out, size_t max) {
+  size_t k = 0;
+  while(k < max && ts_tok_step(t, &out[k])) k++;
+  return k;
+}
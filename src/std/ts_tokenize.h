@@ -0,0 +1,53 @@
+#ifndef TS_TOKENIZE_H__
+#define TS_TOKENIZE_H__
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// ts_tok_t splits a buffer without allocating, tokens are (offset, length) pairs into it.
+/// same token rules as sdssplitlen: separators delimit tokens, two separators in a row give
+/// an empty token, an empty buffer gives no token at all.
+///
+///   ts_tok_t   t;
+///   ts_token_t tok;
+///   ts_tok_init(&t, line, len, ",", 1);
+///   while(ts_tok_next(&t, &tok))
+///     handle(line + tok.off, tok.len);
+///
+/// ts_tok_batch fills a caller array with up to max tokens per call, e.g. one call per line
+/// with a fixed size array on the stack.
+
+// single byte separators are found with SIMD compares (32 bytes per step with AVX2, 16 with
+// SSE2). the match bits of a block are kept in the iterator, so dense separators (csv, tsv)
+// cost one compare per block instead of one memchr call per token.
+// multi byte separators go through memmem.
+
+typedef struct {
+  size_t off;
+  size_t len;
+} ts_token_t;
+
+typedef struct {
+  const char *buf;
+  size_t      n;
+  const char *sep;
+  size_t      sepn;
+  size_t      pos;      // start of the next token
+  size_t      scan;     // first byte not yet compared (single byte separator)
+  size_t      base;     // offset of bit 0 of mask
+  uint64_t    mask;     // separator positions found but not consumed yet
+  int         done;
+} ts_tok_t;
+
+TSC_EXTERN void   ts_tok_init(ts_tok_t *t, const char *buf, size_t n, const char *sep, size_t sepn);
+TSC_EXTERN int    ts_tok_next(ts_tok_t *t, ts_token_t *tok);
+TSC_EXTERN size_t ts_tok_batch(ts_tok_t *t, ts_token_t *out, size_t max);
+
+static inline ts_strview_t ts_tok_sv(const ts_tok_t *t, ts_token_t tok) {
+  return ts_sv(t->buf + tok.off, tok.len);
+}
+
+#endif
@@ -0,0 +1,284 @@
+#include "libts.h"
+
+#define TS_UTF8_ASCII8 0x8080808080808080ULL
+
+// index of the first non ASCII byte in [i, n), 16 / 8 bytes per step
+static inline size_t ts_utf8_skip_ascii(const uint8_t *p, size_t i, size_t n) {
+  uint64_t w;
+#if defined(__SSE2__)
+  for( ; i + 16 <= n ; i += 16) {
+    int m = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(p + i)));
+    if(m) return i + (size_t) __builtin_ctz((unsigned) m);
+  }
+#endif
+  for( ; i + 8 <= n ; i += 8) {
+    memcpy(&w, p + i, 8);
+    if(w & TS_UTF8_ASCII8) break;
+  }
+  while(i < n && p[i] < 0x80) i++;
+  return i;
+}
+
+#if defined(__AVX2__)
+
+// error bits for a byte (prev1) followed by a byte (input)
+#define TS_UTF8_TOO_SHORT      (1 << 0)   // lead followed by lead / ASCII
+#define TS_UTF8_TOO_LONG       (1 << 1)   // ASCII followed by continuation
+#define TS_UTF8_OVERLONG_3     (1 << 2)   // E0 80..9F
+#define TS_UTF8_TOO_LARGE      (1 << 3)   // F4 90..BF, F5..FF
+#define TS_UTF8_SURROGATE      (1 << 4)   // ED A0..BF
+#define TS_UTF8_OVERLONG_2     (1 << 5)   // C0..C1
+#define TS_UTF8_TOO_LARGE_1000 (1 << 6)   // F5..FF 80..8F
+#define TS_UTF8_OVERLONG_4     (1 << 6)   // F0 80..8F
+#define TS_UTF8_TWO_CONTS      (1 << 7)   // continuation followed by continuation
+#define TS_UTF8_CARRY          (TS_UTF8_TOO_SHORT | TS_UTF8_TOO_LONG | TS_UTF8_TWO_CONTS)
+
+#define TS_UTF8_TABLE(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)                   \
+  _mm256_setr_epi8(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p,                      \
+                   a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)
+
+// bytes of input shifted right by k, the missing ones come from the end of prev
+#define TS_UTF8_PREV(input, prev, k)                                                    \
+  _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - (k))
+
+static inline __m256i ts_utf8_check_block(__m256i input, __m256i prev) {
+  const __m256i lo4 = _mm256_set1_epi8(0x0F);
+  const __m256i byte_1_high = TS_UTF8_TABLE(
+    TS_UTF8_TOO_LONG, TS_UTF8_TOO_LONG, TS_UTF8_TOO_LONG, TS_UTF8_TOO_LONG,
+    TS_UTF8_TOO_LONG, TS_UTF8_TOO_LONG, TS_UTF8_TOO_LONG, TS_UTF8_TOO_LONG,
+    TS_UTF8_TWO_CONTS, TS_UTF8_TWO_CONTS, TS_UTF8_TWO_CONTS, TS_UTF8_TWO_CONTS,
+    TS_UTF8_TOO_SHORT | TS_UTF8_OVERLONG_2,
+    TS_UTF8_TOO_SHORT,
+    TS_UTF8_TOO_SHORT | TS_UTF8_OVERLONG_3 | TS_UTF8_SURROGATE,
+    TS_UTF8_TOO_SHORT | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000 | TS_UTF8_OVERLONG_4);
+  const __m256i byte_1_low = TS_UTF8_TABLE(
+    TS_UTF8_CARRY | TS_UTF8_OVERLONG_3 | TS_UTF8_OVERLONG_2 | TS_UTF8_OVERLONG_4,
+    TS_UTF8_CARRY | TS_UTF8_OVERLONG_2,
+    TS_UTF8_CARRY,
+    TS_UTF8_CARRY,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000 | TS_UTF8_SURROGATE,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000,
+    TS_UTF8_CARRY | TS_UTF8_TOO_LARGE | TS_UTF8_TOO_LARGE_1000);
+  const __m256i byte_2_high = TS_UTF8_TABLE(
+    TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT,
+    TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT,
+    TS_UTF8_TOO_LONG | TS_UTF8_OVERLONG_2 | TS_UTF8_TWO_CONTS | TS_UTF8_OVERLONG_3 |
+      TS_UTF8_TOO_LARGE_1000 | TS_UTF8_OVERLONG_4,
+    TS_UTF8_TOO_LONG | TS_UTF8_OVERLONG_2 | TS_UTF8_TWO_CONTS | TS_UTF8_OVERLONG_3 |
+      TS_UTF8_TOO_LARGE,
+    TS_UTF8_TOO_LONG | TS_UTF8_OVERLONG_2 | TS_UTF8_TWO_CONTS | TS_UTF8_SURROGATE |
+      TS_UTF8_TOO_LARGE,
+    TS_UTF8_TOO_LONG | TS_UTF8_OVERLONG_2 | TS_UTF8_TWO_CONTS | TS_UTF8_SURROGATE |
+      TS_UTF8_TOO_LARGE,
+    TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT, TS_UTF8_TOO_SHORT);
+
+  __m256i prev1 = TS_UTF8_PREV(input, prev, 1);
+  __m256i prev2 = TS_UTF8_PREV(input, prev, 2);
+  __m256i prev3 = TS_UTF8_PREV(input, prev, 3);
+  __m256i special = _mm256_and_si256(_mm256_and_si256(
+    _mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lo4)),
+    _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, lo4))),
+    _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), lo4)));
+  // the 2nd continuation of a 3 / 4 byte sequence or the 3rd of a 4 byte one must be there
+  __m256i must23 = _mm256_or_si256(
+    _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+    _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80))));
+  __m256i must23_80 = _mm256_and_si256(must23, _mm256_set1_epi8((char) 0x80));
+  return _mm256_xor_si256(must23_80, special);
+}
+
+int ts_utf8_validate(const char *s, size_t n) {
+  const uint8_t *p = (const uint8_t *) s;
+  // a lead byte in the last 3 positions whose sequence doesn't fit in the block
+  const __m256i  max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, (char)(0xF0 - 1), (char)(0xE0 - 1),
+                                        (char)(0xC0 - 1));
+  __m256i  prev = _mm256_setzero_si256(), err = prev, incomplete = prev, in;
+  uint8_t  tail[32];
+  size_t   i = 0;
+
+  for( ; i + 32 <= n ; i += 32) {
+    in = _mm256_loadu_si256((const __m256i *)(p + i));
+    if(_mm256_movemask_epi8(in) == 0) {
+      err = _mm256_or_si256(err, incomplete);
+    } else {
+      err        = _mm256_or_si256(err, ts_utf8_check_block(in, prev));
+      incomplete = _mm256_subs_epu8(in, max);
+    }
+    prev = in;
+  }
+  // the zero padded tail also catches a sequence cut off at the end
+  memset(tail, 0, sizeof(tail));
+  memcpy(tail, p + i, n - i);
+  in  = _mm256_loadu_si256((const __m256i *) tail);
+  err = _mm256_or_si256(err, ts_utf8_check_block(in, prev));
+  return _mm256_testz_si256(err, err);
+}
+
+#else
+
+int ts_utf8_validate(const char *s, size_t n) {
+  const uint8_t *p = (const uint8_t *) s;
+  size_t         i = 0, k;
+  uint32_t       cp;
+  while( (i = ts_utf8_skip_ascii(p, i, n)) < n ) {
+    if( (k = ts_utf8_decode(p + i, p + n, &cp)) == 0 ) return 0;
+    i += k;
+  }
+  return 1;
+}
+
+#endif
+
+size_t ts_utf8_count(const char *s, size_t n) {
+  const uint8_t *p = (const uint8_t *) s;
+  size_t         count = 0, i = 0;
+#if defined(__AVX2__)
+  const __m256i  cont = _mm256_set1_epi8(-65);   // continuation bytes are -128..-65 signed
+  for( ; i + 32 <= n ; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    count += (size_t) __builtin_popcount((unsigned) _mm256_movemask_epi8(
+      _mm256_cmpgt_epi8(v, cont)));
+  }
+#elif defined(__SSE2__)
+  const __m128i  cont = _mm_set1_epi8(-65);
+  for( ; i + 16 <= n ; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+    count += (size_t) __builtin_popcount((unsigned) _mm_movemask_epi8(
+      _mm_cmpgt_epi8(v, cont)));
+  }
+#endif
+  for( ; i < n ; i++) count += (p[i] & 0xC0) != 0x80;
+  return count;
+}
+
+size_t ts_utf8_utf16_len(const char *s, size_t n) {
+  const uint8_t *p = (const uint8_t *) s;
+  size_t         extra = 0;
+  // every 4 byte sequence becomes a surrogate pair
+  for(size_t i = 0 ; i < n ; i++) extra += p[i] >= 0xF0;
+  return ts_utf8_count(s, n) + extra;
+}
+
+const char * ts_utf8_to_utf16(uint16_t *out, size_t *outn, const char *s, size_t n) {
+  const uint8_t *p = (const uint8_t *) s;
+  size_t         i = 0, o = 0, k, a;
+  uint32_t       cp;
+  while(i < n) {
+    // widen the ASCII run first
+    a = ts_utf8_skip_ascii(p, i, n);
+#if defined(__SSE2__)
+    for( ; i + 16 <= a ; i += 16, o += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(p + i)), z = _mm_setzero_si128();
+      _mm_storeu_si128((__m128i *)(out + o), _mm_unpacklo_epi8(v, z));
+      _mm_storeu_si128((__m128i *)(out + o + 8), _mm_unpackhi_epi8(v, z));
+    }
+#endif
+    while(i < a) out[o++] = p[i++];
+    if(i == n) break;
+    tsunlikely_if( (k = ts_utf8_decode(p + i, p + n, &cp)) == 0 )
+      return "INVALID UTF-8";
+    i += k;
+    if(cp < 0x10000) {
+      out[o++] = (uint16_t) cp;
+    } else {
+      cp      -= 0x10000;
+      out[o++] = (uint16_t)(0xD800 | cp >> 10);
+      out[o++] = (uint16_t)(0xDC00 | (cp & 0x3FF));
+    }
+  }
+  *outn = o;
+  return NULL;
+}
+
+const char * ts_utf8_to_utf32(uint32_t *out, size_t *outn, const char *s, size_t n) {
+  const uint8_t *p = (const uint8_t *) s;
+  size_t         i = 0, o = 0, k, a;
+  uint32_t       cp;
+  while(i < n) {
+    a = ts_utf8_skip_ascii(p, i, n);
+#if defined(__SSE2__)
+    for( ; i + 16 <= a ; i += 16, o += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(p + i)), z = _mm_setzero_si128();
+      __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+      _mm_storeu_si128((__m128i *)(out + o),      _mm_unpacklo_epi16(lo, z));
+      _mm_storeu_si128((__m128i *)(out + o + 4),  _mm_unpackhi_epi16(lo, z));
+      _mm_storeu_si128((__m128i *)(out + o + 8),  _mm_unpacklo_epi16(hi, z));
+      _mm_storeu_si128((__m128i *)(out + o + 12), _mm_unpackhi_epi16(hi, z));
+    }
+#endif
+    while(i < a) out[o++] = p[i++];
+    if(i == n) break;
+    tsunlikely_if( (k = ts_utf8_decode(p + i, p + n, &cp)) == 0 )
+      return "INVALID UTF-8";
+    i       += k;
+    out[o++] = cp;
+  }
+  *outn = o;
+  return NULL;
+}
+
+const char * ts_utf16_to_utf8(char *out, size_t *outn, const uint16_t *p, size_t n) {
+  size_t   i = 0, o = 0;
+  uint32_t cp;
+  while(i < n) {
+#if defined(__SSE2__)
+    // 8 units below 0x80 narrow to 8 bytes
+    for( ; i + 8 <= n ; i += 8, o += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+      if(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short) 0xFF80)),
+                                           _mm_setzero_si128())) != 0xFFFF) break;
+      _mm_storel_epi64((__m128i *)(out + o), _mm_packus_epi16(v, v));
+    }
+    if(i == n) break;
+#endif
+    cp = p[i++];
+    if(cp >= 0xD800 && cp <= 0xDFFF) {
+      tsunlikely_if(cp > 0xDBFF || i == n || p[i] < 0xDC00 || p[i] > 0xDFFF)
+        return "INVALID UTF-16";
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (uint32_t)(p[i++] - 0xDC00);
+    }
+    o += ts_utf8_encode(out + o, cp);
+  }
+  *outn = o;
+  return NULL;
+}
+
+const char * ts_utf32_to_utf8(char *out, size_t *outn, const uint32_t *p, size_t n) {
+  size_t o = 0;
+  for(size_t i = 0 ; i < n ; i++) {
+    tsunlikely_if(p[i] > 0x10FFFF || (p[i] >= 0xD800 && p[i] <= 0xDFFF))
+      return "INVALID UTF-32";
+    o += ts_utf8_encode(out + o, p[i]);
+  }
+  *outn = o;
+  return NULL;
+}
+
+#define TS_UTF8_CAT_SDS(name, type, conv, maxb)                                         \
+const char * name(sds *s, const type *p, size_t n) {                                    \
+  const char *estr;                                                                     \
+  size_t      k;                                                                        \
+  sds         tmp;                                                                      \
+  tsunlikely_if( (tmp = sdsMakeRoomFor(*s, (maxb) * n)) == NULL )                       \
+    return "OOM";                                                                       \
+  *s = tmp;                                                                             \
+  tsunlikely_if( (estr = conv(*s + sdslen(*s), &k, p, n)) != NULL )                     \
+    return estr;                                                                        \
+  sdssetlen(*s, sdslen(*s) + k);                                                        \
+  (*s)[sdslen(*s)] = '\0';                                                              \
+  return NULL;                                                                          \
+}
+
+TS_UTF8_CAT_SDS(ts_utf16_cat_sds, uint16_t, ts_utf16_to_utf8, 3)
+TS_UTF8_CAT_SDS(ts_utf32_cat_sds, uint32_t, ts_utf32_to_utf8, 4)
@@ -0,0 +1,90 @@
+#ifndef TS_UTF8_H__
+#define TS_UTF8_H__
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// UTF-8 validation, code point counting and UTF-8 <-> UTF-16 / UTF-32 transcoding.
+///
+///   ts_utf8_validate(p, n)        1 if p is well formed UTF-8 (no overlongs, no surrogates,
+///                                 nothing above U+10FFFF, no truncated sequence at the end)
+///   ts_utf8_count(p, n)           code points in valid UTF-8 (counts non continuation bytes)
+///   ts_utf8_utf16_len(p, n)       UTF-16 units needed for valid UTF-8
+///
+/// validation with AVX2 checks 32 bytes per step without branches (the lookup table algorithm
+/// of Keiser and Lemire: 3 nibble table lookups classify every pair of adjacent bytes).
+/// without AVX2, blocks of 16 (SSE2) / 8 bytes of ASCII are skipped at once and only the
+/// other bytes are decoded one sequence at a time.
+///
+/// transcoders write to a caller buffer and return an error on malformed input:
+///   ts_utf8_to_utf16 / ts_utf8_to_utf32   out needs room for n units
+///   ts_utf16_to_utf8                      out needs room for 3 * n bytes
+///   ts_utf32_to_utf8                      out needs room for 4 * n bytes
+/// *outn receives the number of units / bytes written. the _cat_sds variants append the
+/// UTF-8 output to an sds instead.
+
+TSC_EXTERN int          ts_utf8_validate(const char *p, size_t n);
+TSC_EXTERN size_t       ts_utf8_count(const char *p, size_t n);
+TSC_EXTERN size_t       ts_utf8_utf16_len(const char *p, size_t n);
+
+TSC_EXTERN const char * ts_utf8_to_utf16(uint16_t *out, size_t *outn, const char *p, size_t n);
+TSC_EXTERN const char * ts_utf8_to_utf32(uint32_t *out, size_t *outn, const char *p, size_t n);
+TSC_EXTERN const char * ts_utf16_to_utf8(char *out, size_t *outn, const uint16_t *p, size_t n);
+TSC_EXTERN const char * ts_utf32_to_utf8(char *out, size_t *outn, const uint32_t *p, size_t n);
+TSC_EXTERN const char * ts_utf16_cat_sds(sds *s, const uint16_t *p, size_t n);
+TSC_EXTERN const char * ts_utf32_cat_sds(sds *s, const uint32_t *p, size_t n);
+
+// decodes the sequence at p (p < end), returns its length, 0 if it is malformed
+static inline size_t ts_utf8_decode(const uint8_t *p, const uint8_t *end, uint32_t *cp) {
+  uint32_t c = p[0];
+  if(c < 0x80) { *cp = c; return 1; }
+  if(c < 0xC2) return 0;
+  if(c < 0xE0) {
+    if(end - p < 2 || (p[1] & 0xC0) != 0x80) return 0;
+    *cp = (c & 0x1F) << 6 | (p[1] & 0x3F);
+    return 2;
+  }
+  if(c < 0xF0) {
+    if(end - p < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80) return 0;
+    c = (c & 0x0F) << 12 | (uint32_t)(p[1] & 0x3F) << 6 | (p[2] & 0x3F);
+    if(c < 0x800 || (c >= 0xD800 && c <= 0xDFFF)) return 0;
+    *cp = c;
+    return 3;
+  }
+  if(c < 0xF5) {
+    if(end - p < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 ||
+       (p[3] & 0xC0) != 0x80) return 0;
+    c = (c & 0x07) << 18 | (uint32_t)(p[1] & 0x3F) << 12 | (uint32_t)(p[2] & 0x3F) << 6 |
+        (p[3] & 0x3F);
+    if(c < 0x10000 || c > 0x10FFFF) return 0;
+    *cp = c;
+    return 4;
+  }
+  return 0;
+}
+
+// writes cp (a valid scalar value) to dst, returns the number of bytes written
+static inline size_t ts_utf8_encode(char *dst, uint32_t cp) {
+  if(cp < 0x80) { dst[0] = (char) cp; return 1; }
+  if(cp < 0x800) {
+    dst[0] = (char)(0xC0 | cp >> 6);
+    dst[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if(cp < 0x10000) {
+    dst[0] = (char)(0xE0 | cp >> 12);
+    dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  dst[0] = (char)(0xF0 | cp >> 18);
+  dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+  dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+  dst[3] = (char)(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+#endif
@@ -9,6 +9,17 @@
 // CAUTION, if OOM happens in resize / copy / push, you are responsible for cleaning up dst
 // Not possible to do it here b/c we don't have info on the resources pointed by a[i]
 
+// storage goes through ts_vec_realloc / ts_vec_free, which know the old size of the buffer.
+// with USE_TS_BIGALLOC they map to the mremap backed ts_big_* allocator, in which case
+// v.a must only be released with destroy (never free it directly).
+#ifdef USE_TS_BIGALLOC
+  #define ts_vec_realloc(p, oldsz, newsz) ts_big_realloc((p), (oldsz), (newsz))
+  #define ts_vec_free(p, sz)              ts_big_free((p), (sz))
+#else
+  #define ts_vec_realloc(p, oldsz, newsz) realloc((p), (newsz))
+  #define ts_vec_free(p, sz)              free((p))
+#endif
+
 #define ts_roundup32(x) (--(x), (x)|=(x)>>1, (x)|=(x)>>2, (x)|=(x)>>4, (x)|=(x)>>8, (x)|=(x)>>16, ++(x))
 #define ts_vec_resize(name, v, s) ts_vec_##name##_resize(&(v),(s))
 #define ts_vec_copy(name, d, s) ts_vec_##name##_copy(&(d),&(s))
@@ -23,7 +34,7 @@
 #define ts_vec_any(name,v) ts_vec_##name##_any(&(v))
 
 #define ts_vec_init(v) ((v).n = (v).m = 0, (v).a = 0)
-#define ts_vec_destroy(v) free((v).a)
+#define ts_vec_destroy(v) ts_vec_free((v).a, sizeof(*(v).a) * (v).m)
 #define ts_vec_A(v, i) ((v).a[(i)])
 #define ts_vec_pop(v) ((v).a[--(v).n])
 #define ts_vec_size(v) ((v).n)
@@ -38,7 +49,8 @@
   typedef struct { size_t n, m; type *a; } ts_vec_##name##_t;                          \
   static inline const char* ts_vec_##name##_resize(ts_vec_##name##_t *v, size_t s) {  \
     type *tmp;                                                                          \
-    tsunlikely_if((tmp = (type*)realloc(v->a, sizeof(type) * s)) == NULL )                        \
+    tmp = (type*)ts_vec_realloc(v->a, sizeof(type) * v->m, sizeof(type) * s);           \
+    tsunlikely_if(tmp == NULL)                                                          \
       return "OOM";                                                                     \
     v->m = s; v->a = tmp; return NULL; }                                                \
   static inline const char*                                                             \
@@ -159,7 +171,8 @@
 #define ts_make_vec(name, type)                                                         \
   typedef struct { size_t n, m; type *a; } name##_t;                                    \
   static inline void name##_init(name##_t *v) { v->n = 0; v->m = 0; v->a = 0; }         \
-  static inline void name##_destroy(name##_t *v) { free(v->a); }                        \
+  static inline void name##_destroy(name##_t *v) {                                      \
+    ts_vec_free(v->a, sizeof(type) * v->m); }                                           \
   static inline void name##_clear(name##_t *v) { v->n = 0; }                            \
   static inline type name##_elem(name##_t *v, size_t i) { return v->a[i]; }             \
   static inline type name##_at(name##_t *v, size_t i) { return v->a[i]; }               \
@@ -171,7 +184,8 @@
   static inline type* name##_ptr(name##_t *v) { return v->a; }                          \
   static inline const char* name##_resize(name##_t *v, size_t s) {                      \
     type *tmp;                                                                          \
-    tsunlikely_if((tmp = (type*)realloc(v->a, sizeof(type) * s)) == NULL )              \
+    tmp = (type*)ts_vec_realloc(v->a, sizeof(type) * v->m, sizeof(type) * s);           \
+    tsunlikely_if(tmp == NULL)                                                          \
       return "OOM";                                                                     \
     v->m = s; v->a = tmp; return NULL; }                                                \
   static inline const char* name##_copy(name##_t *dst, name##_t *src) {                 \
@@ -251,5 +265,54 @@
     for(size_t i = 0 ; i < v->n ; ++i)                                                  \
       ret = ret || !!(v->a[i]);                                                         \
     return ret; }
-    
+
+// fused map / filter / reduce over a vec made with ts_make_vec(name, type)
+// in _pipeline / _fold / _map_filter every stage is optional (pass NULL to skip it), the
+// single stage _filter / _reduce need theirs. all stages share one walk over v->a,
+// so a chain of operations touches memory once instead of once per stage.
+// stages are passed as function pointers to static inline functions, with optimization on
+// the compiler sees the constant pointer at the call site and inlines the stage.
+#define ts_make_vec_pipeline(name, type)                                                \
+  typedef type (*name##_map_fn)(type);                                                  \
+  typedef int  (*name##_filter_fn)(type);                                               \
+  typedef type (*name##_reduce_fn)(type, type);                                         \
+  static inline type name##_pipeline(name##_t *v, name##_map_fn map,                    \
+    name##_filter_fn pred, name##_reduce_fn reduce, type init) {                        \
+    type acc = init, x; size_t j = 0;                                                   \
+    for(size_t i = 0 ; i < v->n ; ++i) {                                                \
+      x = map ? map(v->a[i]) : v->a[i];                                                 \
+      if(pred && !pred(x)) continue;                                                    \
+      if(reduce) acc = reduce(acc, x);                                                  \
+      v->a[j++] = x;                                                                    \
+    }                                                                                   \
+    v->n = j; return acc; }                                                             \
+  static inline type name##_fold(name##_t *v, name##_map_fn map,                        \
+    name##_filter_fn pred, name##_reduce_fn reduce, type init) {                        \
+    type acc = init, x;                                                                 \
+    for(size_t i = 0 ; i < v->n ; ++i) {                                                \
+      x = map ? map(v->a[i]) : v->a[i];                                                 \
+      if(pred && !pred(x)) continue;                                                    \
+      if(reduce) acc = reduce(acc, x);                                                  \
+    }                                                                                   \
+    return acc; }                                                                       \
+  static inline void name##_map_filter(name##_t *v, name##_map_fn map,                  \
+    name##_filter_fn pred) {                                                            \
+    type x; size_t j = 0;                                                               \
+    for(size_t i = 0 ; i < v->n ; ++i) {                                                \
+      x = map ? map(v->a[i]) : v->a[i];                                                 \
+      if(pred && !pred(x)) continue;                                                    \
+      v->a[j++] = x;                                                                    \
+    }                                                                                   \
+    v->n = j; }                                                                         \
+  static inline void name##_filter(name##_t *v, name##_filter_fn pred) {                \
+    size_t j = 0;                                                                       \
+    for(size_t i = 0 ; i < v->n ; ++i)                                                  \
+      if(pred(v->a[i])) v->a[j++] = v->a[i];                                            \
+    v->n = j; }                                                                         \
+  static inline type name##_reduce(name##_t *v, name##_reduce_fn reduce, type init) {   \
+    type acc = init;                                                                    \
+    for(size_t i = 0 ; i < v->n ; ++i)                                                  \
+      acc = reduce(acc, v->a[i]);                                                       \
+    return acc; }
+
 #endif
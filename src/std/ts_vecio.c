@@ -0,0 +1,107 @@
+#include "libts.h"
+
+const char * ts_vecio_save(const char *path, const void *a, size_t elemsz, size_t n) {
+  ts_vecio_hdr_t  hdr;
+  auto_file       fp = NULL;
+  
+  memcpy(hdr.magic, TS_VECIO_MAGIC, sizeof(hdr.magic));
+  hdr.elemsz    = elemsz;
+  hdr.n         = n;
+  hdr.checksum  = ts_hash_bytes(a, elemsz * n);
+  
+  tsunlikely_if( (fp = fopen(path, "wb")) == NULL )
+    return strerror(errno);
+  tsunlikely_if(fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+    return "FWRITE FAILED";
+  tsunlikely_if(n && fwrite(a, elemsz, n, fp) != n)
+    return "FWRITE FAILED";
+  tsunlikely_if(fflush(fp) != 0)
+    return strerror(errno);
+  // fclose can still fail on some filesystems (NFS reports write errors late)
+  tsunlikely_if(fclose(fp) != 0) {
+    fp = NULL;
+    return strerror(errno);
+  }
+  fp = NULL;
+  return NULL;
+}
+
+static const char * ts_vecio_check_hdr(const ts_vecio_hdr_t *hdr, size_t elemsz) {
+  tsunlikely_if(memcmp(hdr->magic, TS_VECIO_MAGIC, sizeof(hdr->magic)) != 0)
+    return "NOT A VEC FILE";
+  tsunlikely_if(hdr->elemsz != elemsz)
+    return "VEC FILE ELEMENT SIZE MISMATCH";
+  return NULL;
+}
+
+// also checks hdr->n against the file size, so a crafted header can't make the caller
+// allocate or read more than the file holds
+const char * ts_vecio_read_hdr(ts_vecio_hdr_t *hdr, FILE *fp, size_t elemsz) {
+  const char  *estr;
+  struct stat  st;
+  tsunlikely_if(fread(hdr, sizeof(*hdr), 1, fp) != 1)
+    return "TRUNCATED VEC FILE";
+  tsunlikely_if( (estr = ts_vecio_check_hdr(hdr, elemsz)) != NULL )
+    return estr;
+  tsunlikely_if(fstat(fileno(fp), &st) == -1)
+    return strerror(errno);
+  tsunlikely_if((size_t) st.st_size < sizeof(*hdr) ||
+                hdr->n > ((size_t) st.st_size - sizeof(*hdr)) / elemsz)
+    return "TRUNCATED VEC FILE";
+  return NULL;
+}
+
+const char * ts_vecio_mmap(ts_vecio_map_t *map, const void **a, size_t *n,
+  const char *path, size_t elemsz, int verify)
+{
+  const char      *estr;
+  ts_vecio_hdr_t  *hdr;
+  struct stat     st;
+  int             fd, err;
+  
+  map->base = NULL;
+  map->len  = 0;
+  
+  tsunlikely_if( (fd = open(path, O_RDONLY)) == -1 )
+    return strerror(errno);
+  if(fstat(fd, &st) == -1) {
+    err = errno;  // close may overwrite it
+    close(fd);
+    return strerror(err);
+  }
+  if((size_t) st.st_size < sizeof(ts_vecio_hdr_t)) {
+    close(fd);
+    return "TRUNCATED VEC FILE";
+  }
+  
+  map->len  = (size_t) st.st_size;
+  map->base = mmap(NULL, map->len, PROT_READ, MAP_PRIVATE, fd, 0);
+  err       = errno;
+  close(fd);  // the mapping keeps its own reference to the file
+  if(map->base == MAP_FAILED) {
+    map->base = NULL;
+    return strerror(err);
+  }
+  
+  hdr = (ts_vecio_hdr_t *) map->base;
+  if( (estr = ts_vecio_check_hdr(hdr, elemsz)) == NULL ) {
+    if(hdr->n > (map->len - sizeof(*hdr)) / elemsz)
+      estr = "TRUNCATED VEC FILE";
+    else if(verify && ts_hash_bytes(hdr + 1, hdr->n * elemsz) != hdr->checksum)
+      estr = "VEC FILE CHECKSUM MISMATCH";
+  }
+  if(estr) {
+    ts_vecio_unmap(map);
+    return estr;
+  }
+  
+  *a = (const void *) (hdr + 1);
+  *n = (size_t) hdr->n;
+  return NULL;
+}
+
+void ts_vecio_unmap(ts_vecio_map_t *map) {
+  if(map->base) munmap(map->base, map->len);
+  map->base = NULL;
+  map->len  = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef TS_VECIO_H__
+#define TS_VECIO_H__
+
+/// binary on-disk format for vecs, so large index arrays can be saved once and mapped back
+/// in O(1) at startup instead of being re-parsed.
+///
+/// layout (native endianness, not meant to move across architectures):
+///   ts_vecio_hdr_t (32 bytes) | raw payload of n * elemsz bytes
+/// the payload starts 32 bytes into a page aligned mapping, so it is aligned for any
+/// element type up to 32 byte alignment.
+
+// ts_make_vec_io(name, type) adds to a vec made with ts_make_vec(name, type):
+//   name##_save(v, path)                    write header + payload
+//   name##_load(v, path)                    read into a normal heap vec (checksum verified)
+//   name##_load_mmap(v, map, path, verify)  v->a points straight into a read only MAP_PRIVATE
+//                                           mapping. verify = 0 skips the checksum pass (O(1)).
+// a vec from load_mmap has m == 0 and is read only: don't push / resize / destroy it,
+// release it with ts_vecio_unmap(map) instead.
+
+#define TS_VECIO_MAGIC "TSVEC\0\0\1"
+
+typedef struct {
+  char      magic[8];
+  uint64_t  elemsz;
+  uint64_t  n;
+  uint64_t  checksum;   // ts_hash_bytes of the payload
+} ts_vecio_hdr_t;
+
+typedef struct {
+  void   *base;
+  size_t  len;
+} ts_vecio_map_t;
+
+TSC_EXTERN const char * ts_vecio_save(const char *path, const void *a, size_t elemsz, size_t n);
+TSC_EXTERN const char * ts_vecio_read_hdr(ts_vecio_hdr_t *hdr, FILE *fp, size_t elemsz);
+TSC_EXTERN const char * ts_vecio_mmap(ts_vecio_map_t *map, const void **a, size_t *n,
+  const char *path, size_t elemsz, int verify);
+TSC_EXTERN void         ts_vecio_unmap(ts_vecio_map_t *map);
+
+#define ts_make_vec_io(name, type)                                                      \
+  static inline const char* name##_save(name##_t *v, const char *path) {                \
+    return ts_vecio_save(path, v->a, sizeof(type), v->n); }                             \
+  static inline const char* name##_load(name##_t *v, const char *path) {                \
+    const char *estr; ts_vecio_hdr_t hdr;                                               \
+    auto_file fp = fopen(path, "rb");                                                   \
+    tsunlikely_if(fp == NULL) return strerror(errno);                                   \
+    tsunlikely_if( (estr = ts_vecio_read_hdr(&hdr, fp, sizeof(type))) != NULL )         \
+      return estr;                                                                      \
+    tsunlikely_if(hdr.n > SIZE_MAX / sizeof(type))                                      \
+      return "VEC FILE TOO LARGE";                                                      \
+    if(v->m < hdr.n)                                                                    \
+      tsunlikely_if( (estr = name##_resize(v, hdr.n)) != NULL )                         \
+        return estr;                                                                    \
+    tsunlikely_if(fread(v->a, sizeof(type), hdr.n, fp) != hdr.n)                        \
+      return "TRUNCATED VEC FILE";                                                      \
+    tsunlikely_if(ts_hash_bytes(v->a, sizeof(type) * hdr.n) != hdr.checksum)            \
+      return "VEC FILE CHECKSUM MISMATCH";                                              \
+    v->n = hdr.n; return NULL; }                                                        \
+  static inline const char* name##_load_mmap(name##_t *v, ts_vecio_map_t *map,          \
+    const char *path, int verify) {                                                     \
+    const char *estr; const void *a; size_t n;                                          \
+    estr = ts_vecio_mmap(map, &a, &n, path, sizeof(type), verify);                      \
+    tsunlikely_if(estr != NULL) return estr;                                            \
+    v->a = (type *) a; v->n = n; v->m = 0; return NULL; }
+
+#endif
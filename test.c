@@ -1,4 +1,14 @@
 #define USE_TS_TEST
+#define USE_TS_CHMAP
+#define USE_TS_BIGALLOC
+#define USE_TS_QUEUE
+#define USE_TS_POOL
+#define USE_TS_HPOOL
+
+// lets the btree tests make chunk allocations fail
+static int btree_fail_malloc;
+#define TS_BTREE_MALLOC(sz) (btree_fail_malloc ? NULL : malloc(sz))
+
 #include "tsc.h"
 
 void base64_enc_test1(void) {
@@ -85,6 +95,10 @@ void suite_matrix_alloc(void) {
 
 ts_make_vec(int_vec, int)
 ts_make_vec_extra(int_vec, int)
+ts_make_vec_pipeline(int_vec, int)
+ts_make_vec_io(int_vec, int)
+ts_make_vec_sorted_int(int_vec, int)
+ts_make_vec_pack(int_vec, int)
 
 void vec_basic(void) {
   int_vec_t a;
@@ -157,18 +171,1441 @@ void vec_foreach(void) {
   int_vec_destroy(&a);
 }
 
+static int  int_sq(int x)         { return x * x; }
+static int  int_is_odd(int x)     { return x & 1; }
+static int  int_add(int x, int y) { return x + y; }
+
+void vec_pipeline(void) {
+  int_vec_t a;
+  int_vec_init(&a);
+  for(int i = 1 ; i <= 10 ; i++)
+    int_vec_push(&a, i);
+  
+  TEST_ASSERT(55 == int_vec_reduce(&a, int_add, 0));
+  TEST_ASSERT(165 == int_vec_fold(&a, int_sq, int_is_odd, int_add, 0));
+  TEST_ASSERT(10 == int_vec_size(&a));
+  
+  TEST_ASSERT(165 == int_vec_pipeline(&a, int_sq, int_is_odd, int_add, 0));
+  TEST_ASSERT(5 == int_vec_size(&a));
+  TEST_ASSERT(1 == int_vec_first(&a));
+  TEST_ASSERT(81 == int_vec_last(&a));
+  
+  int_vec_map_filter(&a, int_sq, NULL);
+  TEST_ASSERT(6561 == int_vec_last(&a));
+  
+  int_vec_push(&a, 2);
+  int_vec_filter(&a, int_is_odd);
+  TEST_ASSERT(5 == int_vec_size(&a));
+  
+  int_vec_destroy(&a);
+}
+void vec_save_load(void) {
+  char            path[] = "/tmp/tsc_test_vec_XXXXXX";
+  int             fd = mkstemp(path);
+  ts_vecio_map_t  map;
+  int_vec_t       a, b, c;
+  TEST_ASSERT(fd != -1);
+  close(fd);
+  int_vec_init(&a);
+  int_vec_init(&b);
+  int_vec_init(&c);
+  for(int i = 0 ; i < 1000 ; i++)
+    int_vec_push(&a, i * i);
+  
+  TEST_ASSERT(int_vec_save(&a, path) == NULL);
+  TEST_ASSERT(int_vec_load(&b, path) == NULL);
+  TEST_ASSERT(1000 == int_vec_size(&b));
+  TEST_ASSERT(memcmp(a.a, b.a, sizeof(int) * 1000) == 0);
+  
+  TEST_ASSERT(int_vec_load_mmap(&c, &map, path, 1) == NULL);
+  TEST_ASSERT(1000 == int_vec_size(&c));
+  TEST_ASSERT(998001 == int_vec_last(&c));
+  ts_vecio_unmap(&map);
+  
+  TEST_ASSERT(int_vec_load_mmap(&c, &map, "/nonexistent/vec.bin", 0) != NULL);
+  
+  // a header promising more elements than the file holds is rejected before resizing
+  TEST_ASSERT(truncate(path, sizeof(ts_vecio_hdr_t) + 10) == 0);
+  TEST_ASSERT(int_vec_load(&b, path) != NULL && 1000 == int_vec_size(&b));
+  TEST_ASSERT(int_vec_load_mmap(&c, &map, path, 0) != NULL);
+  
+  unlink(path);
+  int_vec_destroy(&a);
+  int_vec_destroy(&b);
+}
 
 void suite_vec(void) {
   TEST_REG(vec_basic);
   TEST_REG(vec_foreach);
+  TEST_REG(vec_pipeline);
+  TEST_REG(vec_save_load);
+}
+
+ts_make_deque(int_deque, int)
+
+void deque_basic(void) {
+  int *p1, *p2, buf[16];
+  size_t n1, n2;
+  int_deque_t q;
+  int_deque_init(&q);
+  
+  for(int i = 0 ; i < 6 ; i++)
+    int_deque_push(&q, i);
+  for(int i = 1 ; i <= 3 ; i++)
+    int_deque_pushfront(&q, -i);
+  
+  TEST_ASSERT(9 == int_deque_size(&q));
+  TEST_ASSERT(16 == int_deque_max(&q));
+  TEST_ASSERT(-3 == int_deque_first(&q));
+  TEST_ASSERT(5 == int_deque_last(&q));
+  TEST_ASSERT(0 == int_deque_at(&q, 3));
+  
+  int_deque_segments(&q, &p1, &n1, &p2, &n2);
+  TEST_ASSERT(n1 + n2 == 9);
+  
+  TEST_ASSERT(-3 == int_deque_popfront(&q));
+  TEST_ASSERT(5 == int_deque_pop(&q));
+  TEST_ASSERT(7 == int_deque_drain(&q, buf, 16));
+  TEST_ASSERT(-2 == buf[0] && 4 == buf[6]);
+  TEST_ASSERT(0 == int_deque_size(&q));
+  
+  int_deque_destroy(&q);
+}
+
+void deque_wrap(void) {
+  int buf[4];
+  int_deque_t q;
+  int_deque_init(&q);
+  
+  // keep the window sliding so head wraps around the ring many times
+  for(int i = 0 ; i < 100 ; i++) {
+    int_deque_push(&q, i);
+    if(int_deque_size(&q) > 3)
+      int_deque_popfront(&q);
+  }
+  TEST_ASSERT(4 == int_deque_max(&q));
+  TEST_ASSERT(97 == int_deque_first(&q));
+  TEST_ASSERT(3 == int_deque_drain(&q, buf, 4));
+  TEST_ASSERT(97 == buf[0] && 98 == buf[1] && 99 == buf[2]);
+  
+  int_deque_destroy(&q);
+}
+
+void suite_deque(void) {
+  TEST_REG(deque_basic);
+  TEST_REG(deque_wrap);
+}
+
+ts_make_hmap(int_map, int, int, ts_hash_u64, ts_hash_eq)
+ts_make_hmap(str_map, const char *, int, ts_hash_str, ts_hash_str_eq)
+
+void hmap_basic(void) {
+  int *vp, absent;
+  str_map_t h;
+  str_map_init(&h);
+  
+  TEST_ASSERT(str_map_get(&h, "one") == NULL);
+  TEST_ASSERT(str_map_put(&h, "one", 1) == NULL);
+  TEST_ASSERT(str_map_put(&h, "two", 2) == NULL);
+  TEST_ASSERT(str_map_put(&h, "one", 11) == NULL);
+  TEST_ASSERT(2 == str_map_size(&h));
+  TEST_ASSERT(11 == *str_map_get(&h, "one"));
+  
+  TEST_ASSERT(str_map_put_ptr(&h, "three", &vp, &absent) == NULL);
+  TEST_ASSERT(absent == 1);
+  *vp = 3;
+  TEST_ASSERT(str_map_put_ptr(&h, "three", &vp, &absent) == NULL);
+  TEST_ASSERT(absent == 0 && *vp == 3);
+  
+  TEST_ASSERT(1 == str_map_del(&h, "two"));
+  TEST_ASSERT(0 == str_map_del(&h, "two"));
+  TEST_ASSERT(str_map_get(&h, "two") == NULL);
+  TEST_ASSERT(2 == str_map_size(&h));
+  
+  str_map_destroy(&h);
+}
+
+void hmap_stress(void) {
+  int ok = 1, sum = 0, cnt = 0;
+  int_map_t h;
+  int_map_init(&h);
+  
+  TEST_ASSERT(int_map_reserve(&h, 1000) == NULL);
+  for(int i = 0 ; i < 5000 ; i++)
+    int_map_put(&h, i * 7, i);
+  for(int i = 0 ; i < 5000 ; i += 2)
+    int_map_del(&h, i * 7);
+  TEST_ASSERT(2500 == int_map_size(&h));
+  
+  for(int i = 0 ; i < 5000 ; i++) {
+    int *vp = int_map_get(&h, i * 7);
+    if(i % 2 == 0) ok = ok && vp == NULL;
+    else           ok = ok && vp != NULL && *vp == i;
+  }
+  TEST_ASSERT(ok);
+  
+  ts_hmap_foreach(h, i) {
+    cnt++;
+    sum += ts_hmap_val(h, i) & 1;
+  }
+  TEST_ASSERT(2500 == cnt && 2500 == sum);
+  
+  int_map_destroy(&h);
+}
+
+void suite_hmap(void) {
+  TEST_REG(hmap_basic);
+  TEST_REG(hmap_stress);
+}
+
+ts_make_chmap(int_cmap, int, int, ts_hash_u64, ts_hash_eq, 8)
+
+void chmap_basic(void) {
+  int v;
+  int_cmap_t h;
+  TEST_ASSERT(int_cmap_init(&h) == NULL);
+  
+  TEST_ASSERT(int_cmap_put(&h, 1, 10) == NULL);
+  TEST_ASSERT(int_cmap_put(&h, 2, 20) == NULL);
+  TEST_ASSERT(int_cmap_get(&h, 2, &v) && v == 20);
+  TEST_ASSERT(!int_cmap_get(&h, 3, &v));
+  TEST_ASSERT(1 == int_cmap_del(&h, 1));
+  TEST_ASSERT(1 == int_cmap_size(&h));
+  
+  int_cmap_destroy(&h);
+}
+
+void chmap_bulk_load(void) {
+  int keys[4000], vals[4000], v, ok = 1;
+  int_cmap_t h;
+  TEST_ASSERT(int_cmap_init(&h) == NULL);
+  
+  for(int i = 0 ; i < 4000 ; i++) {
+    keys[i] = i;
+    vals[i] = i * 3;
+  }
+  TEST_ASSERT(int_cmap_bulk_load(&h, keys, vals, 4000, 4) == NULL);
+  TEST_ASSERT(4000 == int_cmap_size(&h));
+  for(int i = 0 ; i < 4000 ; i++)
+    ok = ok && int_cmap_get(&h, i, &v) && v == i * 3;
+  TEST_ASSERT(ok);
+  
+  int_cmap_destroy(&h);
+}
+
+void suite_chmap(void) {
+  TEST_REG(chmap_basic);
+  TEST_REG(chmap_bulk_load);
+}
+
+ts_make_spsc_queue(int_spsc, int, 64)
+ts_make_mpmc_queue(int_mpmc, int, 64)
+
+#define QUEUE_N 200000
+
+static void* spsc_producer(void *p) {
+  int buf[7], next = 0;
+  int_spsc_t *q = (int_spsc_t*) p;
+  while(next < QUEUE_N) {
+    size_t k = QUEUE_N - next < 7 ? QUEUE_N - next : 7;
+    for(size_t i = 0 ; i < k ; i++) buf[i] = next + (int)i;
+    for(size_t i = 0, done ; i < k ; i += done)
+      if( (done = int_spsc_push_n(q, buf + i, k - i)) == 0 ) sched_yield();
+    next += (int)k;
+  }
+  return NULL;
+}
+
+void queue_spsc(void) {
+  int ok = 1, x, buf[5];
+  pthread_t  tid;
+  int_spsc_t q;
+  TEST_ASSERT(int_spsc_init(&q, 0) == NULL);
+  
+  TEST_ASSERT(!int_spsc_pop(&q, &x));
+  for(int i = 0 ; i < 64 ; i++) ok = ok && int_spsc_push(&q, i);
+  TEST_ASSERT(ok && !int_spsc_push(&q, 64) && 64 == int_spsc_size(&q));
+  for(int i = 0 ; i < 64 ; i++) ok = ok && int_spsc_pop(&q, &x) && x == i;
+  TEST_ASSERT(ok && 0 == int_spsc_size(&q));
+  
+  // in order across threads, with batches wrapping around the ring
+  TEST_ASSERT(pthread_create(&tid, NULL, spsc_producer, &q) == 0);
+  for(int next = 0 ; next < QUEUE_N ; ) {
+    size_t k = int_spsc_pop_n(&q, buf, 5);
+    if(k == 0) sched_yield();
+    for(size_t i = 0 ; i < k ; i++) ok = ok && buf[i] == next++;
+  }
+  pthread_join(tid, NULL);
+  TEST_ASSERT(ok);
+  
+  int_spsc_destroy(&q);
+}
+
+static void* mpmc_producer(void *p) {
+  int_mpmc_t *q = (int_mpmc_t*) p;
+  for(int i = 1 ; i <= QUEUE_N ; i++) int_mpmc_push_wait(q, i);
+  return NULL;
+}
+
+static long long mpmc_sum;
+static void* mpmc_consumer(void *p) {
+  int_mpmc_t *q = (int_mpmc_t*) p;
+  long long sum = 0;
+  int x;
+  while( (x = int_mpmc_pop_wait(q)) != 0 ) sum += x;
+  __atomic_fetch_add(&mpmc_sum, sum, __ATOMIC_SEQ_CST);
+  return NULL;
+}
+
+void queue_mpmc(void) {
+  int buf[100], ok = 1;
+  pthread_t  prod[4], cons[4];
+  int_mpmc_t q;
+  TEST_ASSERT(int_mpmc_init(&q, 1) == NULL);
+  
+  for(int i = 0 ; i < 100 ; i++) buf[i] = i;
+  TEST_ASSERT(64 == int_mpmc_push_n(&q, buf, 100) && !int_mpmc_push(&q, 1));
+  TEST_ASSERT(64 == int_mpmc_pop_n(&q, buf, 100) && 0 == int_mpmc_size(&q));
+  for(int i = 0 ; i < 64 ; i++) ok = ok && buf[i] == i;
+  TEST_ASSERT(ok);
+  
+  // 4 producers, 4 blocking consumers, 0 tells a consumer to stop
+  for(int i = 0 ; i < 4 ; i++) {
+    pthread_create(&prod[i], NULL, mpmc_producer, &q);
+    pthread_create(&cons[i], NULL, mpmc_consumer, &q);
+  }
+  for(int i = 0 ; i < 4 ; i++) pthread_join(prod[i], NULL);
+  for(int i = 0 ; i < 4 ; i++) int_mpmc_push_wait(&q, 0);
+  for(int i = 0 ; i < 4 ; i++) pthread_join(cons[i], NULL);
+  TEST_ASSERT(mpmc_sum == 4LL * QUEUE_N * (QUEUE_N + 1) / 2);
+  
+  int_mpmc_destroy(&q);
+}
+
+void suite_queue(void) {
+  TEST_REG(queue_spsc);
+  TEST_REG(queue_mpmc);
+}
+
+#define int_less(a, b) ((a) < (b))
+ts_make_heap(int_heap, int, int_less)
+ts_make_heap4(int_heap4, int, int_less)
+
+typedef struct { int key; size_t pos; } job_t;
+#define job_less(a, b)    ((a).key < (b).key)
+#define job_pos(e, idx)   ((e)->pos = (idx))
+ts_make_heap_ext(job_heap, job_t, job_less, job_pos, 2)
+
+void heap_basic(void) {
+  int ok = 1, prev = -1, x;
+  int_heap_t  h;
+  int_heap4_t h4;
+  int_heap_init(&h);
+  int_heap4_init(&h4);
+  
+  for(int i = 0 ; i < 100 ; i++) {
+    int_heap_push(&h, (i * 37) % 100);
+    int_heap4_push(&h4, (i * 37) % 100);
+  }
+  TEST_ASSERT(0 == int_heap_top(&h));
+  while(int_heap_size(&h) > 0) {
+    x   = int_heap_pop(&h);
+    ok  = ok && x > prev && x == int_heap4_pop(&h4);
+    prev = x;
+  }
+  TEST_ASSERT(ok && prev == 99);
+  
+  int_heap_destroy(&h);
+  int_heap4_destroy(&h4);
+}
+
+void heap_from_vec(void) {
+  int_vec_t  v;
+  int_heap_t h;
+  int_vec_init(&v);
+  for(int i = 10 ; i > 0 ; i--)
+    int_vec_push(&v, i);
+  
+  ts_heap_from_vec(h, v);
+  int_heap_heapify(&h);
+  TEST_ASSERT(0 == int_vec_size(&v));
+  TEST_ASSERT(10 == int_heap_size(&h));
+  TEST_ASSERT(1 == int_heap_pop(&h));
+  TEST_ASSERT(2 == int_heap_pop(&h));
+  
+  int_heap_destroy(&h);
+}
+
+void heap_decrease_key(void) {
+  job_t      jobs[8];
+  job_heap_t h;
+  job_heap_init(&h);
+  for(int i = 0 ; i < 8 ; i++) {
+    jobs[i].key = 10 + i;
+    job_heap_push(&h, jobs[i]);
+  }
+  
+  // find job with key 15 through the position it was given
+  size_t idx = h.n;
+  for(size_t i = 0 ; i < h.n ; i++)
+    if(job_heap_at(&h, i).key == 15) idx = i;
+  TEST_ASSERT(job_heap_at(&h, idx).pos == idx);
+  
+  job_heap_ptr(&h, idx)->key = 1;
+  job_heap_update(&h, idx);
+  TEST_ASSERT(1 == job_heap_top(&h).key);
+  TEST_ASSERT(0 == job_heap_top(&h).pos);
+  
+  job_heap_remove(&h, job_heap_top(&h).pos);
+  TEST_ASSERT(10 == job_heap_pop(&h).key);
+  TEST_ASSERT(6 == job_heap_size(&h));
+  
+  job_heap_destroy(&h);
+}
+
+void suite_heap(void) {
+  TEST_REG(heap_basic);
+  TEST_REG(heap_from_vec);
+  TEST_REG(heap_decrease_key);
+}
+
+void bitset_basic(void) {
+  size_t cnt = 0, sum = 0;
+  ts_bitset_t b;
+  TEST_ASSERT(ts_bitset_init(&b, 1000) == NULL);
+  
+  for(size_t i = 0 ; i < 1000 ; i += 3)
+    ts_bitset_set(&b, i);
+  ts_bitset_clear(&b, 3);
+  
+  TEST_ASSERT(333 == ts_bitset_popcount(&b));
+  TEST_ASSERT(ts_bitset_test(&b, 999) && !ts_bitset_test(&b, 3));
+  TEST_ASSERT(0 == ts_bitset_find_first(&b));
+  TEST_ASSERT(6 == ts_bitset_find_next(&b, 1));
+  TEST_ASSERT(1000 == ts_bitset_find_next(&b, 1000));
+  
+  ts_bitset_foreach(&b, i) {
+    cnt++;
+    sum += i;
+  }
+  TEST_ASSERT(333 == cnt && 166833 - 3 == sum);
+  
+  ts_bitset_setall(&b);
+  TEST_ASSERT(1000 == ts_bitset_popcount(&b));
+  
+  ts_bitset_destroy(&b);
+}
+
+void bitset_ops(void) {
+  ts_bitset_t a, b, c, d;
+  TEST_ASSERT(ts_bitset_init(&a, 700) == NULL);
+  TEST_ASSERT(ts_bitset_init(&b, 700) == NULL);
+  TEST_ASSERT(ts_bitset_init(&c, 700) == NULL);
+  TEST_ASSERT(ts_bitset_init(&d, 10) == NULL);
+  
+  for(size_t i = 0 ; i < 700 ; i += 2) ts_bitset_set(&a, i);
+  for(size_t i = 0 ; i < 700 ; i += 3) ts_bitset_set(&b, i);
+  
+  TEST_ASSERT(ts_bitset_and(&c, &a, &b) == NULL);
+  TEST_ASSERT(117 == ts_bitset_popcount(&c));
+  TEST_ASSERT(ts_bitset_or(&c, &a, &b) == NULL);
+  TEST_ASSERT(467 == ts_bitset_popcount(&c));
+  TEST_ASSERT(ts_bitset_xor(&c, &a, &b) == NULL);
+  TEST_ASSERT(350 == ts_bitset_popcount(&c));
+  TEST_ASSERT(ts_bitset_andnot(&c, &a, &b) == NULL);
+  TEST_ASSERT(233 == ts_bitset_popcount(&c));
+  TEST_ASSERT(ts_bitset_and(&d, &a, &b) != NULL);
+  
+  TEST_ASSERT(ts_bitset_build_rank(&b) == NULL);
+  TEST_ASSERT(0 == ts_bitset_rank(&b, 0));
+  TEST_ASSERT(1 == ts_bitset_rank(&b, 1));
+  TEST_ASSERT(200 == ts_bitset_rank(&b, 600));
+  TEST_ASSERT(234 == ts_bitset_rank(&b, 700));
+  TEST_ASSERT(0 == ts_bitset_select(&b, 0));
+  TEST_ASSERT(600 == ts_bitset_select(&b, 200));
+  TEST_ASSERT(699 == ts_bitset_select(&b, 233));
+  TEST_ASSERT(700 == ts_bitset_select(&b, 234));
+  
+  ts_bitset_destroy(&a);
+  ts_bitset_destroy(&b);
+  ts_bitset_destroy(&c);
+  ts_bitset_destroy(&d);
 }
 
+void suite_bitset(void) {
+  TEST_REG(bitset_basic);
+  TEST_REG(bitset_ops);
+}
+
+ts_make_soa(pts, (float, x), (float, y), (int, id))
+
+void soa_basic(void) {
+  float sum = 0;
+  pts_t v;
+  pts_init(&v);
+  
+  for(int i = 0 ; i < 10 ; i++)
+    TEST_ASSERT(pts_push(&v, (pts_row_t){ .x = i, .y = 2 * i, .id = 100 + i }) == NULL);
+  TEST_ASSERT(10 == pts_size(&v));
+  TEST_ASSERT(16 == pts_max(&v));
+  
+  for(size_t i = 0 ; i < pts_size(&v) ; i++)
+    sum += v.x[i];
+  TEST_ASSERT(45 == sum);
+  
+  pts_erase(&v, 0);
+  TEST_ASSERT(9 == pts_size(&v));
+  TEST_ASSERT(101 == v.id[0] && 2 == v.y[0]);
+  
+  pts_swap_erase(&v, 0);
+  TEST_ASSERT(8 == pts_size(&v));
+  TEST_ASSERT(109 == pts_at(&v, 0).id && 9 == pts_at(&v, 0).x);
+  
+  TEST_ASSERT(108 == pts_pop(&v).id);
+  TEST_ASSERT(pts_compact(&v) == NULL);
+  TEST_ASSERT(7 == pts_max(&v));
+  
+  // compacting an empty soa frees the columns, destroy after it is fine
+  pts_clear(&v);
+  TEST_ASSERT(pts_compact(&v) == NULL && 0 == pts_max(&v) && v.x == NULL && v.id == NULL);
+  TEST_ASSERT(pts_push(&v, (pts_row_t){ .x = 1, .y = 2, .id = 3 }) == NULL && 3 == v.id[0]);
+  
+  pts_destroy(&v);
+}
+
+void suite_soa(void) {
+  TEST_REG(soa_basic);
+}
+
+ts_make_segvec(int_segvec, int)
+
+void segvec_basic(void) {
+  int ok = 1, *first, *p;
+  size_t len, total = 0;
+  int_segvec_t v;
+  int_segvec_init(&v);
+  
+  TEST_ASSERT(int_segvec_push(&v, 0) == NULL);
+  first = int_segvec_ptr(&v, 0);
+  for(int i = 1 ; i < 1000 ; i++)
+    int_segvec_push(&v, i);
+  
+  // growing never moves existing elements
+  TEST_ASSERT(first == int_segvec_ptr(&v, 0));
+  TEST_ASSERT(1000 == int_segvec_size(&v));
+  TEST_ASSERT(1008 == int_segvec_max(&v));
+  for(int i = 0 ; i < 1000 ; i++)
+    ok = ok && i == int_segvec_at(&v, i);
+  TEST_ASSERT(ok);
+  
+  for(unsigned k = 0 ; k < v.nseg ; k++) {
+    int_segvec_segment(&v, k, &p, &len);
+    ok = ok && (len == 0 || p[0] == (int)total);
+    total += len;
+  }
+  TEST_ASSERT(ok && 1000 == total);
+  
+  TEST_ASSERT(999 == int_segvec_pop(&v));
+  TEST_ASSERT(998 == int_segvec_last(&v));
+  
+  int_segvec_destroy(&v);
+}
+
+void suite_segvec(void) {
+  TEST_REG(segvec_basic);
+}
+
+void bigalloc_vec(void) {
+  int ok = 1;
+  int_vec_t a;
+  int_vec_init(&a);
+  
+  // crosses TS_BIG_THRESHOLD, then keeps growing through mremap
+  for(int i = 0 ; i < 4 * 1024 * 1024 ; i++)
+    ok = ok && int_vec_push(&a, i) == NULL;
+  TEST_ASSERT(ok);
+  for(int i = 0 ; i < 4 * 1024 * 1024 ; i += 4099)
+    ok = ok && int_vec_at(&a, i) == i;
+  TEST_ASSERT(ok);
+  TEST_ASSERT(((uintptr_t) int_vec_ptr(&a) & 4095) == 0);  // page aligned, i.e. mapped
+  
+  TEST_ASSERT(int_vec_resize(&a, 1000) == NULL);
+  TEST_ASSERT(999 == int_vec_at(&a, 999));
+  
+  int_vec_destroy(&a);
+}
+
+void bigalloc_sds(void) {
+  auto_sds s = sdsempty();
+  char buf[4096];
+  memset(buf, 'x', sizeof(buf));
+  
+  for(int i = 0 ; i < 1024 ; i++)
+    s = sdscatlen(s, buf, sizeof(buf));
+  TEST_ASSERT(4 * 1024 * 1024 == sdslen(s));
+  TEST_ASSERT('x' == s[4 * 1024 * 1024 - 1] && '\0' == s[4 * 1024 * 1024]);
+  
+  s = sdsRemoveFreeSpace(s);
+  TEST_ASSERT(4 * 1024 * 1024 == sdslen(s));
+}
+
+void suite_bigalloc(void) {
+  TEST_REG(bigalloc_vec);
+  TEST_REG(bigalloc_sds);
+}
+
+ts_make_btree(int_btree, int, int, int_less)
+
+void btree_basic(void) {
+  int ok = 1, n = 0, prev = -1;
+  int_btree_t t;
+  int_btree_init(&t);
+  
+  // 0..9999 in scrambled order, then drop the odd ones (forces splits and merges)
+  for(int i = 0 ; i < 10000 ; i++)
+    ok = ok && int_btree_insert(&t, (i * 7919) % 10000, i) == NULL;
+  TEST_ASSERT(ok && 10000 == int_btree_size(&t));
+  TEST_ASSERT(int_btree_insert(&t, 42, -1) == NULL && 10000 == int_btree_size(&t));
+  TEST_ASSERT(-1 == *int_btree_get(&t, 42));
+  for(int i = 1 ; i < 10000 ; i += 2)
+    ok = ok && int_btree_erase(&t, i);
+  TEST_ASSERT(ok && 5000 == int_btree_size(&t));
+  TEST_ASSERT(!int_btree_erase(&t, 1) && NULL == int_btree_get(&t, 1));
+  
+  for(int_btree_iter_t it = int_btree_begin(&t) ; int_btree_iter_valid(it) ;
+      it = int_btree_iter_next(it), n++) {
+    ok   = ok && int_btree_iter_key(it) > prev && int_btree_iter_key(it) % 2 == 0;
+    prev = int_btree_iter_key(it);
+  }
+  TEST_ASSERT(ok && 5000 == n);
+  
+  // range [101, 111)
+  n = 0;
+  for(int_btree_iter_t it = int_btree_lower_bound(&t, 101) ;
+      int_btree_iter_valid(it) && int_btree_iter_key(it) < 111 ; it = int_btree_iter_next(it))
+    n++;
+  TEST_ASSERT(5 == n);
+  TEST_ASSERT(!int_btree_iter_valid(int_btree_lower_bound(&t, 9999)));
+  
+  for(int i = 0 ; i < 10000 ; i += 2)
+    ok = ok && int_btree_erase(&t, i);
+  TEST_ASSERT(ok && 0 == int_btree_size(&t) && NULL == t.root);
+  
+  int_btree_destroy(&t);
+}
+
+// keys 0, 2, .. 2(n-1) with value key + 1, all found and iterated in order
+static int btree_intact(int_btree_t *t, int n) {
+  int ok = (size_t) n == int_btree_size(t), cnt = 0;
+  for(int i = 0 ; ok && i < n ; i++)
+    ok = int_btree_get(t, 2 * i) != NULL && 2 * i + 1 == *int_btree_get(t, 2 * i);
+  for(int_btree_iter_t it = int_btree_begin(t) ; ok && int_btree_iter_valid(it) ;
+      it = int_btree_iter_next(it), cnt++)
+    ok = 2 * cnt == int_btree_iter_key(it);
+  return ok && cnt == n;
+}
+
+void btree_insert_oom(void) {
+  int              ok = 1, n = 0, k;
+  int_btree_node_t *fl, *nd;
+  int_btree_t      t;
+  int_btree_init(&t);
+  
+  // a full root leaf: the split and the new root can't be allocated
+  for( ; n < int_btree_LCAP ; n++)
+    ok = ok && int_btree_insert(&t, 2 * n, 2 * n + 1) == NULL;
+  fl = t.freelist; t.freelist = NULL; btree_fail_malloc = 1;
+  TEST_ASSERT(ok && int_btree_insert(&t, 2 * n, 2 * n + 1) != NULL);
+  TEST_ASSERT(0 == t.height && btree_intact(&t, n) && NULL == int_btree_get(&t, 2 * n));
+  t.freelist = fl; btree_fail_malloc = 0;
+  
+  // grow until an insert splits a leaf and a full inner node, then leave one free node
+  for(k = 0 ; k < 100000 && (0 == t.height || int_btree__need(&t, 2 * n) < 2) ; k++, n++)
+    ok = ok && int_btree_insert(&t, 2 * n, 2 * n + 1) == NULL;
+  TEST_ASSERT(ok && k < 100000);
+  nd = (int_btree_node_t *) int_btree__alloc(&t);
+  fl = t.freelist; t.freelist = NULL; btree_fail_malloc = 1;
+  int_btree__free(&t, nd);
+  TEST_ASSERT(int_btree_insert(&t, 2 * n, 2 * n + 1) != NULL);
+  TEST_ASSERT(btree_intact(&t, n) && NULL == int_btree_get(&t, 2 * n));
+  TEST_ASSERT(t.freelist == nd);
+  nd->free_next = fl; btree_fail_malloc = 0;
+  TEST_ASSERT(int_btree_insert(&t, 2 * n, 2 * n + 1) == NULL && btree_intact(&t, n + 1));
+  
+  int_btree_destroy(&t);
+}
+
+void btree_bulk_load(void) {
+  int ok = 1, n = 0;
+  int_vec_t   v;
+  int_btree_t t;
+  int_vec_init(&v);
+  int_btree_init(&t);
+  for(int i = 0 ; i < 5000 ; i++)
+    int_vec_push(&v, i * 3);
+  
+  TEST_ASSERT(int_btree_bulk_load(&t, v.a, v.a, v.n) == NULL);
+  TEST_ASSERT(5000 == int_btree_size(&t));
+  for(int i = 0 ; i < 15000 ; i++)
+    ok = ok && (int_btree_get(&t, i) != NULL) == (i % 3 == 0);
+  TEST_ASSERT(ok);
+  for(int_btree_iter_t it = int_btree_begin(&t) ; int_btree_iter_valid(it) ;
+      it = int_btree_iter_next(it))
+    ok = ok && int_btree_iter_key(it) == n++ * 3;
+  TEST_ASSERT(ok && 5000 == n);
+  
+  // the tree stays a regular tree after bulk loading
+  TEST_ASSERT(int_btree_insert(&t, 1, 1) == NULL && 1 == *int_btree_get(&t, 1));
+  TEST_ASSERT(int_btree_erase(&t, 0) && 1 == int_btree_iter_key(int_btree_begin(&t)));
+  TEST_ASSERT(int_btree_bulk_load(&t, v.a, v.a, v.n) != NULL);
+  
+  int_btree_destroy(&t);
+  int_vec_destroy(&v);
+}
+
+void suite_btree(void) {
+  TEST_REG(btree_basic);
+  TEST_REG(btree_insert_oom);
+  TEST_REG(btree_bulk_load);
+}
+
+ts_make_vec(u64_vec, uint64_t)
+ts_make_vec_sorted_int(u64_vec, uint64_t)
+ts_make_vec_pack(u64_vec, uint64_t)
+
+void sorted_search(void) {
+  int ok = 1;
+  int_vec_t v;
+  int_vec_init(&v);
+  for(int i = 0 ; i < 100 ; i++) {
+    int_vec_push(&v, i / 2 * 2);   // 0 0 2 2 4 4 ...
+  }
+  
+  TEST_ASSERT(0 == int_vec_lower_bound(&v, -5) && 100 == int_vec_lower_bound(&v, 1000));
+  for(int x = -1 ; x <= 100 ; x++) {
+    size_t lo = 0, hi = 0;
+    while(lo < v.n && v.a[lo] < x) lo++;
+    while(hi < v.n && v.a[hi] <= x) hi++;
+    ok = ok && lo == int_vec_lower_bound(&v, x) && hi == int_vec_upper_bound(&v, x);
+  }
+  TEST_ASSERT(ok);
+  
+  int_vec_unique(&v);
+  TEST_ASSERT(50 == int_vec_size(&v) && 98 == int_vec_last(&v));
+  TEST_ASSERT(int_vec_contains(&v, 42) && !int_vec_contains(&v, 43));
+  
+  int_vec_destroy(&v);
+}
+
+void sorted_set_ops(void) {
+  int ok = 1;
+  int_vec_t a, b, d;
+  u64_vec_t x, y, z;
+  int_vec_init(&a); int_vec_init(&b); int_vec_init(&d);
+  u64_vec_init(&x); u64_vec_init(&y); u64_vec_init(&z);
+  for(int i = -300 ; i < 1000 ; i++) {
+    if(i % 2 == 0) { int_vec_push(&a, i); u64_vec_push(&x, (uint64_t)(i + 300) * 0x100000001ULL); }
+    if(i % 3 == 0) { int_vec_push(&b, i); u64_vec_push(&y, (uint64_t)(i + 300) * 0x100000001ULL); }
+  }
+  
+  TEST_ASSERT(int_vec_set_intersection(&d, &a, &b) == NULL);
+  for(size_t i = 0 ; i < d.n ; i++) ok = ok && d.a[i] % 6 == 0 && (i == 0 || d.a[i - 1] < d.a[i]);
+  TEST_ASSERT(ok && 217 == d.n);
+  TEST_ASSERT(u64_vec_set_intersection(&z, &x, &y) == NULL && 217 == z.n);
+  for(size_t i = 0 ; i < z.n ; i++) ok = ok && z.a[i] == (uint64_t)(d.a[i] + 300) * 0x100000001ULL;
+  TEST_ASSERT(ok);
+  
+  TEST_ASSERT(int_vec_set_union(&d, &a, &b) == NULL && 650 + 434 - 217 == d.n);
+  TEST_ASSERT(int_vec_set_difference(&d, &a, &b) == NULL && 650 - 217 == d.n);
+  TEST_ASSERT(int_vec_merge(&d, &a, &b) == NULL && 650 + 434 == d.n);
+  for(size_t i = 1 ; i < d.n ; i++) ok = ok && d.a[i - 1] <= d.a[i];
+  TEST_ASSERT(ok);
+  
+  // skewed sizes take the galloping path
+  int_vec_clear(&b);
+  int_vec_push(&b, -300); int_vec_push(&b, 7); int_vec_push(&b, 500);
+  TEST_ASSERT(int_vec_set_intersection(&d, &b, &a) == NULL && 2 == d.n);
+  TEST_ASSERT(-300 == d.a[0] && 500 == d.a[1]);
+  
+  int_vec_destroy(&a); int_vec_destroy(&b); int_vec_destroy(&d);
+  u64_vec_destroy(&x); u64_vec_destroy(&y); u64_vec_destroy(&z);
+}
+
+void suite_sorted(void) {
+  TEST_REG(sorted_search);
+  TEST_REG(sorted_set_ops);
+}
+
+ts_make_slotmap(int_slots, int)
+
+void slotmap_basic(void) {
+  int ok = 1, sum = 0, var;
+  size_t iter;
+  ts_slot_t   h[100], h2 = 0;
+  int_slots_t s;
+  int_slots_init(&s);
+  
+  for(int i = 0 ; i < 100 ; i++)
+    ok = ok && int_slots_insert(&s, i, &h[i]) == NULL && h[i] != 0;
+  TEST_ASSERT(ok && 100 == int_slots_size(&s));
+  
+  // erase the even ones, the odd ones keep their handles
+  for(int i = 0 ; i < 100 ; i += 2)
+    ok = ok && int_slots_erase(&s, h[i]);
+  TEST_ASSERT(ok && 50 == int_slots_size(&s));
+  for(int i = 0 ; i < 100 ; i++)
+    ok = ok && (i % 2 ? *int_slots_get(&s, h[i]) == i : int_slots_get(&s, h[i]) == NULL);
+  TEST_ASSERT(ok);
+  TEST_ASSERT(!int_slots_erase(&s, h[0]));
+  
+  // a reused slot does not revive the old handle
+  TEST_ASSERT(int_slots_insert(&s, 1000, &h2) == NULL);
+  TEST_ASSERT(ts_slot_idx(h2) == ts_slot_idx(h[98]) && !int_slots_contains(&s, h[98]));
+  TEST_ASSERT(1000 == *int_slots_get(&s, h2));
+  
+  // values stay dense
+  ts_vec_foreach(s, var, iter) sum += var;
+  TEST_ASSERT(2500 + 1000 == sum);
+  TEST_ASSERT(h2 == int_slots_handle_at(&s, 50));
+  
+  int_slots_clear(&s);
+  TEST_ASSERT(0 == int_slots_size(&s) && !int_slots_contains(&s, h[1]));
+  
+  int_slots_destroy(&s);
+}
+
+void suite_slotmap(void) {
+  TEST_REG(slotmap_basic);
+}
+
+void intpack_pack(void) {
+  int ok = 1;
+  uint64_t  x = 1000, out[TS_PACK_BLOCK];
+  u64_vec_t v, w;
+  ts_pack_t p;
+  u64_vec_init(&v);
+  u64_vec_init(&w);
+  TEST_ASSERT(ts_pack_init(&p) == NULL);
+  
+  // small gaps, plus one huge gap that forces a raw block
+  for(int i = 0 ; i < 10000 ; i++) {
+    x += (uint64_t)(i * 7919) % 50;
+    if(i == 5000) x += (uint64_t)1 << 40;
+    u64_vec_push(&v, x);
+  }
+  TEST_ASSERT(u64_vec_pack(&v, &p) == NULL && 10000 == ts_pack_size(&p));
+  TEST_ASSERT(ts_pack_bytes(&p) * 4 < v.n * sizeof(uint64_t));
+  TEST_ASSERT(u64_vec_unpack(&w, &p) == NULL && 10000 == w.n);
+  TEST_ASSERT(0 == memcmp(v.a, w.a, sizeof(uint64_t) * v.n));
+  
+  for(size_t i = 0 ; i < v.n ; i += 97)
+    ok = ok && ts_pack_get(&p, i) == v.a[i]
+            && ts_pack_lower_bound(&p, v.a[i]) == u64_vec_lower_bound(&v, v.a[i])
+            && ts_pack_lower_bound(&p, v.a[i] + 1) == u64_vec_lower_bound(&v, v.a[i] + 1);
+  TEST_ASSERT(ok);
+  TEST_ASSERT(0 == ts_pack_lower_bound(&p, 0) && v.n == ts_pack_lower_bound(&p, UINT64_MAX));
+  TEST_ASSERT(16 == ts_pack_decode_block(&p, p.nblocks - 1, out));
+  TEST_ASSERT(out[15] == u64_vec_last(&v));
+  TEST_ASSERT(ts_pack_append(&p, v.a, 1) != NULL);   // last block is partial
+  ts_pack_destroy(&p);
+  
+  // a drop after the first block is caught up front, nothing gets written
+  TEST_ASSERT(ts_pack_init(&p) == NULL);
+  v.a[TS_PACK_BLOCK] = v.a[TS_PACK_BLOCK - 1] - 1;
+  TEST_ASSERT(ts_pack_append(&p, v.a, 2 * TS_PACK_BLOCK) != NULL);
+  TEST_ASSERT(0 == ts_pack_size(&p) && 0 == p.nblocks && 0 == ts_pack_bytes(&p));
+  TEST_ASSERT(ts_pack_append(&p, v.a, TS_PACK_BLOCK) == NULL && TS_PACK_BLOCK == ts_pack_size(&p));
+  
+  ts_pack_destroy(&p);
+  u64_vec_destroy(&v);
+  u64_vec_destroy(&w);
+}
+
+void intpack_signed(void) {
+  int_vec_t v, w;
+  ts_pack_t p;
+  int_vec_init(&v);
+  int_vec_init(&w);
+  TEST_ASSERT(ts_pack_init(&p) == NULL);
+  for(int i = -500 ; i < 500 ; i += 3)
+    int_vec_push(&v, i);
+  
+  TEST_ASSERT(int_vec_pack(&v, &p) == NULL);
+  TEST_ASSERT(int_vec_unpack(&w, &p) == NULL && w.n == v.n);
+  TEST_ASSERT(0 == memcmp(v.a, w.a, sizeof(int) * v.n));
+  
+  ts_pack_destroy(&p);
+  int_vec_destroy(&v);
+  int_vec_destroy(&w);
+}
+
+void intpack_varint(void) {
+  uint64_t a[5] = { 0, 127, 128, 300, UINT64_MAX }, b[5], x;
+  uint8_t  buf[10];
+  size_t   used = 0;
+  auto_sds s = sdsempty();
+  
+  TEST_ASSERT(1 == ts_varint_put(buf, 127) && 2 == ts_varint_put(buf, 128));
+  TEST_ASSERT(10 == ts_varint_put(buf, UINT64_MAX));
+  TEST_ASSERT(10 == ts_varint_get(buf, buf + 10, &x) && UINT64_MAX == x);
+  TEST_ASSERT(0 == ts_varint_get(buf, buf + 9, &x));
+  
+  s = ts_varint_encode(s, a, 4, 1);
+  TEST_ASSERT(1 + 1 + 1 + 2 == sdslen(s));
+  TEST_ASSERT(ts_varint_decode(b, 4, (uint8_t *) s, sdslen(s), &used, 1) == NULL);
+  TEST_ASSERT(used == sdslen(s) && 0 == memcmp(a, b, sizeof(uint64_t) * 4));
+  TEST_ASSERT(ts_varint_decode(b, 5, (uint8_t *) s, sdslen(s), &used, 1) != NULL);
+}
+
+void suite_intpack(void) {
+  TEST_REG(intpack_pack);
+  TEST_REG(intpack_signed);
+  TEST_REG(intpack_varint);
+}
+
+void string_case(void) {
+  int  ok = 1;
+  char buf[200], ref[200];
+  
+  // every length around the 16 / 32 byte steps and every start alignment
+  for(size_t off = 0 ; off < 16 ; off++)
+    for(size_t n = 0 ; n < 100 ; n++) {
+      char *s = buf + off;
+      for(size_t i = 0 ; i < n ; i++) s[i] = ref[i] = (char)(32 + (i * 37 + off) % 224);
+      s[n] = ref[n] = '\0';
+      for(size_t i = 0 ; i < n ; i++)
+        ref[i] = (ref[i] >= 'a' && ref[i] <= 'z') ? ref[i] - 32 : ref[i];
+      ok = ok && 0 == strcmp(ts_upper_inplace(s), ref);
+      for(size_t i = 0 ; i < n ; i++)
+        ref[i] = (ref[i] >= 'A' && ref[i] <= 'Z') ? ref[i] + 32 : ref[i];
+      ok = ok && 0 == memcmp(ts_lower_inplace_n(s, n), ref, n);
+    }
+  TEST_ASSERT(ok);
+  
+  // exact sized heap string, ASan flags any read past the NUL
+  char *h = strdup("hello");
+  TEST_ASSERT(h != NULL && 0 == strcmp("HELLO", ts_upper_inplace(h)));
+  free(h);
+  
+  strcpy(buf, "Hello, World! @[`{");
+  TEST_ASSERT(0 == strcmp("HELLO, WORLD! @[`{", ts_upper_inplace(buf)));
+  TEST_ASSERT(0 == strcmp("hello, world! @[`{", ts_lower_inplace(buf)));
+}
+
+void string_trim(void) {
+  char buf[128];
+  
+  strcpy(buf, " \t\r\n  abc def \v\f ");
+  TEST_ASSERT(0 == strcmp("abc def", ts_trim_inplace(buf)));
+  strcpy(buf, "                                       x                                     ");
+  TEST_ASSERT(0 == strcmp("x                                     ", ts_trimleft_inplace(buf)));
+  TEST_ASSERT(0 == strcmp("x", ts_trimright_inplace(buf)));
+  strcpy(buf, "                                        ");
+  TEST_ASSERT(0 == ts_trim_inplace_n(buf, strlen(buf)) && '\0' == buf[0]);
+  
+  strcpy(buf, "  key: value  ");
+  TEST_ASSERT(10 == ts_trim_inplace_n(buf, 14) && 0 == strcmp("key: value", buf));
+  TEST_ASSERT(10 == ts_trim_inplace_n(buf, 10));
+}
+
+void string_view(void) {
+  int           n = 0, ok = 1;
+  const char   *parts[] = { "a", "", "bc", "d" };
+  char         *dup;
+  ts_strview_t  tok, v = ts_sv_trim(ts_sv_cstr("  key = value \r\n"));
+  ts_sv_split_t it;
+  
+  TEST_ASSERT(ts_sv_eq(v, ts_sv_cstr("key = value")));
+  TEST_ASSERT(ts_sv_startswith(v, ts_sv_cstr("key")) && !ts_sv_startswith(v, ts_sv_cstr("value")));
+  TEST_ASSERT(ts_sv_endswith(v, ts_sv_cstr("value")) && !ts_sv_endswith(v, ts_sv_cstr("key")));
+  TEST_ASSERT(4 == ts_sv_find(v, ts_sv_cstr("= ")) && TS_SV_NPOS == ts_sv_find(v, ts_sv_cstr("==")));
+  TEST_ASSERT(ts_sv_eq(ts_sv_substr(v, 6, 100), ts_sv_cstr("value")));
+  TEST_ASSERT(ts_sv_cmp(ts_sv_cstr("ab"), ts_sv_cstr("abc")) < 0);
+  TEST_ASSERT(ts_sv_cmp(ts_sv_cstr("b"), ts_sv_cstr("abc")) > 0);
+  TEST_ASSERT(0 == ts_sv_cmp(ts_sv_trunc(v, 3), ts_sv_cstr("key")));
+  
+  ts_sv_split_init(&it, ts_sv_cstr("a::::bc::d"), ts_sv_cstr("::"));
+  while(ts_sv_split_next(&it, &tok))
+    ok = ok && n < 4 && ts_sv_eq(tok, ts_sv_cstr(parts[n++]));
+  TEST_ASSERT(ok && 4 == n);
+  
+  TEST_ASSERT(ts_sv_dup(&dup, ts_sv_substr(v, 0, 3)) == NULL && 0 == strcmp("key", dup));
+  free(dup);
+  TEST_ASSERT(ts_startswith("prefix", "pre") && !ts_startswith("pre", "prefix"));
+  TEST_ASSERT(ts_endswith("file.txt", ".txt") && !ts_endswith("txt", "file.txt"));
+}
+
+// checks ts_tok against sdssplitlen on the same input
+static int tokenize_matches_sds(const char *buf, size_t n, const char *sep, size_t sepn) {
+  int        count, ok = 1, k = 0;
+  ts_tok_t   t;
+  ts_token_t tok;
+  sds       *ref = sdssplitlen(buf, (int) n, sep, (int) sepn, &count);
+  ts_tok_init(&t, buf, n, sep, sepn);
+  while(ts_tok_next(&t, &tok)) {
+    ok = ok && k < count && tok.len == sdslen(ref[k]) && 0 == memcmp(buf + tok.off, ref[k], tok.len);
+    k++;
+  }
+  sdsfreesplitres(ref, count);
+  return ok && k == count;
+}
+
+void string_tokenize(void) {
+  int        ok = 1;
+  char       buf[300];
+  ts_tok_t   t;
+  ts_token_t toks[4];
+  
+  for(size_t n = 0 ; n < sizeof(buf) ; n += 7) {
+    for(size_t i = 0 ; i < n ; i++) buf[i] = "ab,:"[(i * i + n) % 4];
+    ok = ok && tokenize_matches_sds(buf, n, ",", 1) && tokenize_matches_sds(buf, n, "::", 2);
+  }
+  TEST_ASSERT(ok);
+  
+  // batch mode, 4 tokens at a time
+  ts_tok_init(&t, "1,22,,333,4444,", 15, ",", 1);
+  TEST_ASSERT(4 == ts_tok_batch(&t, toks, 4));
+  TEST_ASSERT(2 == toks[1].len && 0 == toks[2].len && 6 == toks[3].off);
+  TEST_ASSERT(ts_sv_eq(ts_tok_sv(&t, toks[3]), ts_sv_cstr("333")));
+  TEST_ASSERT(2 == ts_tok_batch(&t, toks, 4) && 4 == toks[0].len && 0 == toks[1].len);
+  TEST_ASSERT(0 == ts_tok_batch(&t, toks, 4));
+}
+
+// naive reference: number of (pattern, end) occurrences, ASCII case folded when nocase
+static size_t search_count_naive(const char **pats, size_t np, const char *text, size_t n,
+                                 int nocase) {
+  size_t count = 0;
+  for(size_t p = 0 ; p < np ; p++) {
+    size_t m = strlen(pats[p]);
+    for(size_t i = 0 ; i + m <= n ; i++)
+      count += nocase ? 0 == strncasecmp(text + i, pats[p], m) : 0 == memcmp(text + i, pats[p], m);
+  }
+  return count;
+}
+
+static int search_last_end(void *ud, size_t pat, size_t end) {
+  *(size_t *) ud = pat * 1000 + end;
+  return 1;
+}
+
+void string_search(void) {
+  int         ok = 1;
+  char        buf[400];
+  const char *needles[] = { "a", "ab", "ba", "abcab", "cabca", "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb" };
+  const char *pats[]    = { "he", "she", "his", "hers", "e", "ushers" };
+  const char *hit;
+  size_t      first = 0;
+  ts_ac_t     ac;
+  
+  for(size_t n = 0 ; n < sizeof(buf) ; n += 13) {
+    for(size_t i = 0 ; i < n ; i++) buf[i] = "abcAB"[(i * i + n) % 5];
+    for(size_t k = 0 ; k < sizeof(needles) / sizeof(needles[0]) ; k++) {
+      size_t m = strlen(needles[k]);
+      ok = ok && ts_search(buf, n, needles[k], m) == memmem(buf, n, needles[k], m);
+      hit = ts_search_nocase(buf, n, needles[k], m);
+      for(size_t i = 0 ; i + m <= n && ok ; i++)
+        if(0 == strncasecmp(buf + i, needles[k], m)) { ok = hit == buf + i; break; }
+        else ok = hit == NULL || hit > buf + i;
+    }
+  }
+  TEST_ASSERT(ok);
+  TEST_ASSERT(ts_search("x", 1, "", 0) != NULL && ts_search("x", 1, "xy", 2) == NULL);
+  
+  // classic example: "ushers" holds she, he, e, hers and ushers itself
+  TEST_ASSERT(ts_ac_init(&ac, 0) == NULL);
+  for(size_t p = 0 ; p < 6 ; p++)
+    TEST_ASSERT(ts_ac_add(&ac, pats[p], strlen(pats[p])) == NULL);
+  TEST_ASSERT(ts_ac_add(&ac, "", 0) != NULL);
+  TEST_ASSERT(ts_ac_build(&ac) == NULL);
+  TEST_ASSERT(5 == ts_ac_scan(&ac, "ushers", 6, NULL, NULL));
+  TEST_ASSERT(1 == ts_ac_scan(&ac, "xxsheyy", 7, search_last_end, &first) && 1005 == first);
+  for(size_t n = 0 ; n < sizeof(buf) ; n += 13) {
+    for(size_t i = 0 ; i < n ; i++) buf[i] = "hseruiHS"[(i * 7 + n * i) % 8];
+    ok = ok && ts_ac_scan(&ac, buf, n, NULL, NULL) == search_count_naive(pats, 6, buf, n, 0);
+  }
+  ts_ac_destroy(&ac);
+  TEST_ASSERT(ok);
+  
+  TEST_ASSERT(ts_ac_init(&ac, 1) == NULL);
+  for(size_t p = 0 ; p < 6 ; p++) ts_ac_add(&ac, pats[p], strlen(pats[p]));
+  TEST_ASSERT(ts_ac_build(&ac) == NULL);
+  for(size_t n = 0 ; n < sizeof(buf) ; n += 13) {
+    for(size_t i = 0 ; i < n ; i++) buf[i] = "hseruiHS"[(i * 7 + n * i) % 8];
+    ok = ok && ts_ac_scan(&ac, buf, n, NULL, NULL) == search_count_naive(pats, 6, buf, n, 1);
+  }
+  ts_ac_destroy(&ac);
+  TEST_ASSERT(ok);
+}
+
+typedef struct { ts_intern_t *tab; const char *ptrs[300]; int ok; } intern_arg_t;
+
+static void * intern_worker(void *arg) {
+  intern_arg_t *a = (intern_arg_t *) arg;
+  char          key[32];
+  for(int i = 0 ; i < 300 ; i++) {
+    int n = snprintf(key, sizeof(key), "field_%d", (i * 7) % 300);
+    a->ok = a->ok && ts_intern(a->tab, key, (size_t) n, &a->ptrs[(i * 7) % 300]) == NULL;
+  }
+  return NULL;
+}
+
+void string_intern(void) {
+  ts_intern_t  tab;
+  const char  *a, *b, *c, *big;
+  char        *text = (char *) malloc(TS_INTERN_CHUNK);
+  intern_arg_t args[3];
+  pthread_t    tids[3];
+  int          ok = 1;
+  
+  TEST_ASSERT(ts_intern_init(&tab, 0) == NULL);
+  TEST_ASSERT(ts_intern(&tab, "name", 4, &a) == NULL && 0 == strcmp(a, "name"));
+  TEST_ASSERT(ts_intern(&tab, "named", 4, &b) == NULL && a == b);
+  TEST_ASSERT(ts_intern(&tab, "value", 5, &c) == NULL && a != c);
+  TEST_ASSERT(0 == ts_intern_id(a) && 1 == ts_intern_id(c) && 5 == ts_intern_len(c));
+  TEST_ASSERT(ts_intern_str(&tab, 1) == c && ts_intern_str(&tab, 2) == NULL);
+  TEST_ASSERT(ts_intern_find(&tab, "value", 5) == c && ts_intern_find(&tab, "val", 3) == NULL);
+  // a string larger than half a chunk is stored on its own
+  memset(text, 'x', TS_INTERN_CHUNK);
+  TEST_ASSERT(ts_intern(&tab, text, TS_INTERN_CHUNK, &big) == NULL);
+  TEST_ASSERT(TS_INTERN_CHUNK == ts_intern_len(big) && 2 == ts_intern_id(big));
+  TEST_ASSERT(ts_intern(&tab, "after", 5, &b) == NULL && b == ts_intern_find(&tab, "after", 5));
+  TEST_ASSERT(4 == ts_intern_size(&tab));
+  ts_intern_destroy(&tab);
+  free(text);
+  
+  // threads interning the same keys all end up with the same pointers
+  TEST_ASSERT(ts_intern_init(&tab, 1) == NULL);
+  for(int t = 0 ; t < 3 ; t++) {
+    args[t].tab = &tab;
+    args[t].ok  = 1;
+    pthread_create(&tids[t], NULL, intern_worker, &args[t]);
+  }
+  for(int t = 0 ; t < 3 ; t++) pthread_join(tids[t], NULL);
+  for(int i = 0 ; i < 300 ; i++)
+    ok = ok && args[0].ptrs[i] == args[1].ptrs[i] && args[1].ptrs[i] == args[2].ptrs[i];
+  TEST_ASSERT(ok && args[0].ok && args[1].ok && args[2].ok && 300 == ts_intern_size(&tab));
+  ts_intern_destroy(&tab);
+}
+
+void string_parse(void) {
+  const char  *floats[] = { "0", "-0.0", "1.5", "3.14159265358979", "1e22", "1e23", "-2.5e-3",
+                            "123456789012345678901234", "4.9e-324", "1.7976931348623157e308",
+                            "0.1", ".5", "5.", "9007199254740993", "1e400", "2.2250738585072014e-308" };
+  ts_strview_t col[4] = { ts_sv_cstr("12"), ts_sv_cstr("-7"), ts_sv_cstr("x"), ts_sv_cstr("3") };
+  int64_t      i64, out[4];
+  uint64_t     u64;
+  double       d;
+  long int     l;
+  size_t       bad = 0;
+  int          ok = 1;
+  char         buf[64];
+  
+  TEST_ASSERT(20 == ts_parse_u64("18446744073709551615", 20, &u64) && UINT64_MAX == u64);
+  TEST_ASSERT(0 == ts_parse_u64("18446744073709551616", 20, &u64));
+  TEST_ASSERT(0 == ts_parse_u64("-1", 2, &u64) && 0 == ts_parse_u64("", 0, &u64));
+  TEST_ASSERT(20 == ts_parse_i64("-9223372036854775808", 20, &i64) && INT64_MIN == i64);
+  TEST_ASSERT(0 == ts_parse_i64("9223372036854775808", 19, &i64));
+  TEST_ASSERT(25 == ts_parse_i64("+000000000000000000001234", 25, &i64) && 1234 == i64);
+  TEST_ASSERT(8 == ts_parse_i64("12345678,9", 10, &i64) && 12345678 == i64);
+  TEST_ASSERT(3 == ts_parse_i64("-42abc", 6, &i64) && -42 == i64);
+  for(int64_t x = -100000 ; x < 100000000000LL ; x = x < 0 ? x / 3 + 1 : x * 7 + 13) {
+    int k = snprintf(buf, sizeof(buf), "%" PRId64, x);
+    ok = ok && (size_t) k == ts_parse_i64(buf, (size_t) k, &i64) && x == i64;
+  }
+  TEST_ASSERT(ok);
+  
+  for(size_t i = 0 ; i < sizeof(floats) / sizeof(floats[0]) ; i++) {
+    size_t k = strlen(floats[i]);
+    double r = strtod(floats[i], NULL);
+    ok = ok && k == ts_parse_f64(floats[i], k, &d) && 0 == memcmp(&d, &r, sizeof(d));
+  }
+  for(int i = 1 ; i < 2000 ; i++) {
+    int k = snprintf(buf, sizeof(buf), "%.*g", 1 + i % 17, (double) i * 1.37e-5 * (i % 3 ? i : 1.0 / i));
+    double r = strtod(buf, NULL);
+    ok = ok && (size_t) k == ts_parse_f64(buf, (size_t) k, &d) && 0 == memcmp(&d, &r, sizeof(d));
+  }
+  TEST_ASSERT(ok);
+  TEST_ASSERT(1 == ts_parse_f64("1e", 2, &d) && 1.0 == d);
+  TEST_ASSERT(9 == ts_parse_f64("-Infinity", 9, &d) && d < 0 && 3 == ts_parse_f64("INFx", 4, &d));
+  TEST_ASSERT(3 == ts_parse_f64("nan", 3, &d) && d != d);
+  TEST_ASSERT(0 == ts_parse_f64(".", 1, &d) && 0 == ts_parse_f64("e5", 2, &d));
+  
+  // the strtod fallback leaves errno alone and ignores LC_NUMERIC (when de_DE is installed)
+  errno = 0;
+  TEST_ASSERT(5 == ts_parse_f64("1e400", 5, &d) && d > DBL_MAX && 0 == errno);
+  if(setlocale(LC_NUMERIC, "de_DE.UTF-8") != NULL) {
+    TEST_ASSERT(7 == ts_parse_f64("1.5e300", 7, &d) && 1.5e300 == d);
+    setlocale(LC_NUMERIC, "C");
+  }
+  
+  TEST_ASSERT(ts_parse_i64_batch(out, col, 4, &bad) != NULL && 2 == bad);
+  TEST_ASSERT(12 == out[0] && -7 == out[1]);
+  TEST_ASSERT(ts_parse_i64_batch(out, col, 2, &bad) == NULL);
+  TEST_ASSERT(ts_strtol(&l, "-123", 10) == NULL && -123 == l);
+  TEST_ASSERT(ts_strtol(&l, "ff", 16) == NULL && 255 == l);
+  TEST_ASSERT(ts_strtol(&l, "12x", 10) != NULL);
+}
+
+void string_format(void) {
+  const char *exp[][2] = { { "0.1", "0.1" }, { "-0", "-0" }, { "100", "100" }, { "1e21", "1e+21" },
+                           { "1e20", "100000000000000000000" }, { "0.000001", "0.000001" },
+                           { "1.5e-7", "1.5e-7" }, { "123.456", "123.456" }, { "5e-324", "5e-324" },
+                           { "1.7976931348623157e308", "1.7976931348623157e+308" },
+                           { "-2.5", "-2.5" }, { "0.30000000000000004", "0.30000000000000004" } };
+  sds      s = sdsempty();
+  int      ok = 1;
+  uint64_t x = 0x9e3779b97f4a7c15ULL;
+  double   d;
+  
+  for(size_t i = 0 ; i < sizeof(exp) / sizeof(exp[0]) ; i++) {
+    sdsclear(s);
+    s  = sdscatdouble(s, strtod(exp[i][0], NULL));
+    ok = ok && 0 == strcmp(s, exp[i][1]);
+  }
+  TEST_ASSERT(ok);
+  // random bit patterns read back to the same double, with at most 17 digits
+  for(int i = 0 ; i < 20000 ; i++) {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    memcpy(&d, &x, sizeof(d));
+    if(d != d || d - d != 0) continue;
+    sdsclear(s);
+    s = sdscatdouble(s, d);
+    double r = strtod(s, NULL);
+    ok = ok && 0 == memcmp(&r, &d, sizeof(d)) && sdslen(s) <= 25;
+  }
+  TEST_ASSERT(ok);
+  sdsclear(s);
+  s = sdscatdouble(sdscatdouble(s, 1.0 / 0.0), -1.0 / 0.0);
+  TEST_ASSERT(0 == strcmp(s, "inf-inf"));
+  
+  sdsclear(s);
+  s = sdscati64(sdscati64(sdscati64(s, INT64_MIN), 0), 1234567);
+  TEST_ASSERT(0 == strcmp(s, "-922337203685477580801234567"));
+  sdsclear(s);
+  s = sdscatfmt(s, "%i|%U|%g|%I", -10, (unsigned long long) UINT64_MAX, 2.5, (long long) 99);
+  TEST_ASSERT(0 == strcmp(s, "-10|18446744073709551615|2.5|99"));
+  sdsfree(s);
+}
+
+// one sequence at a time, the reference for ts_utf8_validate
+static int utf8_valid_naive(const char *s, size_t n) {
+  uint32_t cp;
+  size_t   k;
+  for(size_t i = 0 ; i < n ; i += k)
+    if( (k = ts_utf8_decode((const uint8_t *) s + i, (const uint8_t *) s + n, &cp)) == 0 )
+      return 0;
+  return 1;
+}
+
+void string_utf8(void) {
+  const char *bad[] = { "\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE2\x82", "\x80",
+                        "\xF0\x82\x82\xAC", "\xFF", "a\xC3" };
+  const char *text  = "caf\xC3\xA9 \xE2\x82\xAC 10 \xF0\x9F\x98\x80!";
+  char        buf[200], out8[600];
+  uint16_t    u16[200];
+  uint32_t    u32[200], x = 12345;
+  size_t      n16, n32, n8;
+  int         ok = 1;
+  sds         s = sdsempty();
+  
+  for(size_t i = 0 ; i < sizeof(bad) / sizeof(bad[0]) ; i++) {
+    // at the start, and at every offset around a 32 byte block boundary
+    for(size_t off = 0 ; off < 40 ; off++) {
+      memset(buf, 'a', sizeof(buf));
+      memcpy(buf + off, bad[i], strlen(bad[i]));
+      ok = ok && !ts_utf8_validate(buf, off + strlen(bad[i])) && !ts_utf8_validate(buf, 70);
+    }
+  }
+  TEST_ASSERT(ok);
+  // random byte soup built from valid and broken pieces agrees with the scalar decoder
+  for(int r = 0 ; r < 3000 ; r++) {
+    size_t n = 0;
+    while(n < 150) {
+      x = x * 1103515245 + 12345;
+      const char *piece = (x >> 16) % 7 == 0 ? bad[(x >> 8) % 8] : (x >> 16) % 3 ? "ab" : text;
+      if((x >> 20) % 50 == 0) piece = "\xE2\x82";
+      memcpy(buf + n, piece, strlen(piece));
+      n += strlen(piece);
+    }
+    ok = ok && ts_utf8_validate(buf, n) == utf8_valid_naive(buf, n);
+    ok = ok && ts_utf8_validate(text, strlen(text));
+  }
+  TEST_ASSERT(ok);
+  
+  TEST_ASSERT(12 == ts_utf8_count(text, strlen(text)) && 13 == ts_utf8_utf16_len(text, strlen(text)));
+  TEST_ASSERT(ts_utf8_to_utf16(u16, &n16, text, strlen(text)) == NULL && 13 == n16);
+  TEST_ASSERT(0xE9 == u16[3] && 0x20AC == u16[5] && 0xD83D == u16[10] && 0xDE00 == u16[11]);
+  TEST_ASSERT(ts_utf8_to_utf32(u32, &n32, text, strlen(text)) == NULL && 12 == n32);
+  TEST_ASSERT(0x1F600 == u32[10] && '!' == u32[11]);
+  TEST_ASSERT(ts_utf16_to_utf8(out8, &n8, u16, n16) == NULL && n8 == strlen(text));
+  TEST_ASSERT(0 == memcmp(out8, text, n8));
+  TEST_ASSERT(ts_utf32_to_utf8(out8, &n8, u32, n32) == NULL && 0 == memcmp(out8, text, n8));
+  TEST_ASSERT(ts_utf8_to_utf16(u16, &n16, "a\xED\xA0\x80", 4) != NULL);
+  u16[0] = 0xDC00;
+  TEST_ASSERT(ts_utf16_to_utf8(out8, &n8, u16, 1) != NULL);
+  
+  // long ASCII runs take the SIMD paths
+  memset(buf, 'z', 100);
+  memcpy(buf + 100, text, strlen(text));
+  TEST_ASSERT(ts_utf8_to_utf32(u32, &n32, buf, 100 + strlen(text)) == NULL && 112 == n32);
+  TEST_ASSERT('z' == u32[99] && 'c' == u32[100]);
+  TEST_ASSERT(ts_utf8_to_utf16(u16, &n16, buf, 100 + strlen(text)) == NULL && 113 == n16);
+  TEST_ASSERT(ts_utf16_cat_sds(&s, u16, n16) == NULL && sdslen(s) == 100 + strlen(text));
+  TEST_ASSERT(ts_utf32_cat_sds(&s, u32, n32) == NULL && 0 == memcmp(s + sdslen(s) / 2, buf, sdslen(s) / 2));
+  TEST_ASSERT(112 * 2 == ts_utf8_count(s, sdslen(s)));
+  sdsfree(s);
+}
+
+void string_rope(void) {
+  ts_rope_t r, tail;
+  char     *flat = NULL, big[3000], back[8000];
+  sds       s = sdsempty();
+  FILE     *fp = tmpfile();
+  int       ok = 1;
+  
+  ts_rope_init(&r);
+  TEST_ASSERT(ts_rope_append(&r, "world", 5) == NULL && ts_rope_prepend(&r, "hello ", 6) == NULL);
+  TEST_ASSERT(ts_rope_append_copy(&r, "!", 1) == NULL && ts_rope_prepend_copy(&r, ">> ", 3) == NULL);
+  TEST_ASSERT(15 == ts_rope_len(&r) && 4 == ts_rope_count(&r));
+  TEST_ASSERT(ts_rope_flatten(&flat, &r) == NULL && 0 == strcmp(flat, ">> hello world!"));
+  free(flat);
+  
+  // split in the middle of a piece, the copied "!" lives on in tail after r is gone
+  TEST_ASSERT(ts_rope_split(&r, 7, &tail) == NULL && 7 == ts_rope_len(&r) && 8 == ts_rope_len(&tail));
+  s = ts_rope_catsds(ts_rope_catsds(s, &r), &tail);
+  TEST_ASSERT(0 == strcmp(s, ">> hello world!"));
+  ts_rope_destroy(&r);
+  TEST_ASSERT(ts_rope_flatten(&flat, &tail) == NULL && 0 == strcmp(flat, "o world!"));
+  free(flat);
+  TEST_ASSERT(ts_rope_split(&tail, 100, &r) != NULL);
+  ts_rope_destroy(&tail);
+  
+  // many pieces on both ends, more than IOV_MAX for the writev loop
+  memset(big, 'b', sizeof(big));
+  ts_rope_init(&r);
+  for(int i = 0 ; i < 2000 ; i++) {
+    ok = ok && ts_rope_append(&r, "ab", 2) == NULL && ts_rope_prepend_copy(&r, "xy", 2) == NULL;
+    if(i % 500 == 0) ok = ok && ts_rope_append_copy(&r, big, sizeof(big)) == NULL;
+  }
+  TEST_ASSERT(ok && 8000 + 4 * sizeof(big) == ts_rope_len(&r) && 4004 == ts_rope_count(&r));
+  TEST_ASSERT(ts_rope_iov(&r)[0].iov_len == 2 && 0 == memcmp(ts_rope_iov(&r)[0].iov_base, "xy", 2));
+  TEST_ASSERT(fp != NULL && ts_rope_write(&r, fileno(fp)) == NULL);
+  rewind(fp);
+  TEST_ASSERT(4002 == fread(back, 1, 4002, fp) && 0 == memcmp(back + 3998, "xyab", 4));
+  fclose(fp);
+  ts_rope_clear(&r);
+  TEST_ASSERT(0 == ts_rope_len(&r) && ts_rope_append(&r, "z", 1) == NULL && 1 == ts_rope_count(&r));
+  ts_rope_destroy(&r);
+  sdsfree(s);
+}
+
+static size_t sds_alloc_live;
+
+static void * sds_alloc_count_malloc(void *ctx, size_t size) {
+  (void) ctx;
+  sds_alloc_live += size;
+  return malloc(size);
+}
+
+static void * sds_alloc_count_realloc(void *ctx, void *ptr, size_t oldsize, size_t size) {
+  (void) ctx;
+  sds_alloc_live += size - oldsize;
+  return realloc(ptr, size);
+}
+
+static void sds_alloc_count_free(void *ctx, void *ptr, size_t size) {
+  (void) ctx;
+  sds_alloc_live -= size;
+  free(ptr);
+}
+
+void string_sds_alloc(void) {
+  sdsallocator  counting = { sds_alloc_count_malloc, sds_alloc_count_realloc,
+                             sds_alloc_count_free, NULL };
+  ts_arena_t    ar;
+  sds           s, t, u;
+  char         *p;
+  int           ok = 1;
+  
+  // every byte goes through the allocator, through type changes and shrinking too
+  s = sdsnew_a(&counting, "x");
+  TEST_ASSERT(sdsgetallocator(s) == &counting);
+  for(int i = 0 ; i < 1000 ; i++) ok = ok && (s = sdscat(s, "0123456789")) != NULL;
+  TEST_ASSERT(ok && 10001 == sdslen(s) && sds_alloc_live == sdsAllocSize(s));
+  sdsrange(s, 0, 9);
+  s = sdsRemoveFreeSpace(s);
+  TEST_ASSERT(0 == strcmp(s, "x012345678") && sdsgetallocator(s) == &counting);
+  TEST_ASSERT(sds_alloc_live == sdsAllocSize(s));
+  t = sdsdup(s);
+  TEST_ASSERT(sdsgetallocator(t) == NULL && sds_alloc_live == sdsAllocSize(s));
+  sdsfree(t);
+  sdsfree(s);
+  TEST_ASSERT(0 == sds_alloc_live);
+  
+  // the newest string grows in place, all strings go with one reset
+  ts_arena_init(&ar, 4096);
+  s = sdsempty_a(ts_arena_sdsalloc(&ar));
+  p = s;
+  for(int i = 0 ; i < 50 ; i++) s = sdscatfmt(s, "%i,", i);
+  TEST_ASSERT(s == p && 0 == memcmp(s, "0,1,2,", 6) && sdsgetallocator(s) == ts_arena_sdsalloc(&ar));
+  t = sdsnewlen_a(ts_arena_sdsalloc(&ar), NULL, 10000);
+  TEST_ASSERT(t != NULL && 10000 == sdslen(t) && 0 == t[9999]);
+  t = sdscat(t, "tail");
+  TEST_ASSERT(10004 == sdslen(t) && 0 == strcmp(t + 10000, "tail"));
+  u = sdsnew_a(ts_arena_sdsalloc(&ar), "abc");
+  sdsfree(t);
+  s = sdscat(s, "end");
+  TEST_ASSERT(0 == strcmp(u, "abc") && 0 == strcmp(s + sdslen(s) - 4, ",end"));
+  TEST_ASSERT(NULL == ts_arena_malloc(&ar, SIZE_MAX) && NULL == ts_arena_malloc(&ar, SIZE_MAX - 15));
+  TEST_ASSERT(NULL == ts_arena_realloc(&ar, sdsAllocPtr(u), sdsAllocSize(u), SIZE_MAX - 3));
+  TEST_ASSERT(0 == strcmp(u, "abc"));
+  for(int i = 0 ; i < 2000 ; i++) ok = ok && sdsnew_a(ts_arena_sdsalloc(&ar), "request scoped") != NULL;
+  TEST_ASSERT(ok);
+  ts_arena_reset(&ar);
+  TEST_ASSERT(ar.chunks != NULL && ar.chunks->next == NULL && ar.last == NULL);
+  s = sdsnew_a(ts_arena_sdsalloc(&ar), "again");
+  TEST_ASSERT(0 == strcmp(s, "again") && s > ar.chunks->data && s < ar.end);
+  ts_arena_destroy(&ar);
+}
+
+void suite_string(void) {
+  TEST_REG(string_case);
+  TEST_REG(string_trim);
+  TEST_REG(string_view);
+  TEST_REG(string_tokenize);
+  TEST_REG(string_search);
+  TEST_REG(string_intern);
+  TEST_REG(string_parse);
+  TEST_REG(string_format);
+  TEST_REG(string_utf8);
+  TEST_REG(string_rope);
+  TEST_REG(string_sds_alloc);
+}
+
+// defined after the TSC_DEFINE include below, the pool structs are opaque until then
+void suite_pool(void);
+
 int main(int argc, const char ** argv) {
   (void)argc;
   (void)argv;
   TEST_ADD_SUITE(suite_base64);
   TEST_ADD_SUITE(suite_matrix_alloc);
   TEST_ADD_SUITE(suite_vec);
+  TEST_ADD_SUITE(suite_deque);
+  TEST_ADD_SUITE(suite_hmap);
+  TEST_ADD_SUITE(suite_chmap);
+  TEST_ADD_SUITE(suite_queue);
+  TEST_ADD_SUITE(suite_heap);
+  TEST_ADD_SUITE(suite_bitset);
+  TEST_ADD_SUITE(suite_soa);
+  TEST_ADD_SUITE(suite_segvec);
+  TEST_ADD_SUITE(suite_bigalloc);
+  TEST_ADD_SUITE(suite_btree);
+  TEST_ADD_SUITE(suite_sorted);
+  TEST_ADD_SUITE(suite_slotmap);
+  TEST_ADD_SUITE(suite_intpack);
+  TEST_ADD_SUITE(suite_string);
+  TEST_ADD_SUITE(suite_pool);
   
   //~ size_t    ndirs;
   //~ auto_cstr dirs_ptr  = NULL;
@@ -186,3 +1623,37 @@ int main(int argc, const char ** argv) {
 
 #define TSC_DEFINE
 #include "tsc.h"
+
+void pool_sds(void) {
+  ts_pool_t     pool;
+  ts_hpool_t    hpool;
+  sdsallocator  pa, ha;
+  sds           s, t;
+  int           ok = 1;
+  
+  // a 10 KB string grows through several sds types inside each pool and is given back
+  TEST_ASSERT(ts_pool_init(&pool, NULL, 65536) == NULL);
+  ts_pool_sdsalloc(&pa, &pool);
+  s = sdsnew_a(&pa, "pool:");
+  for(int i = 0 ; i < 1000 ; i++) ok = ok && (s = sdscat(s, "0123456789")) != NULL;
+  TEST_ASSERT(ok && 10005 == sdslen(s) && sdsgetallocator(s) == &pa);
+  TEST_ASSERT(0 == memcmp(s, "pool:0123", 9) && 0 == strcmp(s + 10000, "56789"));
+  t = sdsnew_a(&pa, "second");
+  s = sdsRemoveFreeSpace(s);
+  TEST_ASSERT(s != NULL && 0 == strcmp(t, "second") && 0 == sdsavail(s));
+  sdsfree(s);
+  sdsfree(t);
+  ts_pool_deinit(&pool);
+  
+  TEST_ASSERT(ts_hpool_init(&hpool, NULL, 65536) == NULL);
+  ts_hpool_sdsalloc(&ha, &hpool);
+  s = sdsempty_a(&ha);
+  for(int i = 0 ; i < 1000 ; i++) ok = ok && (s = sdscatfmt(s, "%i,", i % 10)) != NULL;
+  TEST_ASSERT(ok && 2000 == sdslen(s) && 0 == memcmp(s + 1990, "5,6,7,8,9,", 10));
+  sdsfree(s);
+  ts_hpool_deinit(&hpool);
+}
+
+void suite_pool(void) {
+  TEST_REG(pool_sds);
+}